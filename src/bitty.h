@@ -285,6 +285,12 @@
 #ifndef BITTY_MAP_MAX_HEIGHT
 #	define BITTY_MAP_MAX_HEIGHT 4096
 #endif /* BITTY_MAP_MAX_HEIGHT */
+#ifndef BITTY_MAP_BATCH_CHUNK_SIZE
+#	define BITTY_MAP_BATCH_CHUNK_SIZE 32
+#endif /* BITTY_MAP_BATCH_CHUNK_SIZE */
+#ifndef BITTY_MAP_BATCH_MEMORY_BUDGET
+#	define BITTY_MAP_BATCH_MEMORY_BUDGET (32 * 1024 * 1024)
+#endif /* BITTY_MAP_BATCH_MEMORY_BUDGET */
 
 #ifndef BITTY_TEXTURE_SAFE_MAX_WIDTH
 #	define BITTY_TEXTURE_SAFE_MAX_WIDTH 32768
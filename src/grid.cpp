@@ -0,0 +1,175 @@
+/*
+** Bitty
+**
+** An itty bitty game engine.
+**
+** Copyright (C) 2020 - 2025 Tony Wang, all rights reserved
+**
+** For the latest info, see https://github.com/paladin-t/bitty/
+*/
+
+#include "grid.h"
+
+/*
+** {===========================================================================
+** Macros and constants
+*/
+
+#ifndef GRID_CEL_LOOKUP_MAX_COUNT
+#	define GRID_CEL_LOOKUP_MAX_COUNT 65536
+#endif /* GRID_CEL_LOOKUP_MAX_COUNT */
+
+#ifndef GRID_BITS_MAX_AREA
+#	define GRID_BITS_MAX_AREA (16384ll * 16384ll)
+#endif /* GRID_BITS_MAX_AREA */
+
+/* ===========================================================================} */
+
+/*
+** {===========================================================================
+** Grid
+*/
+
+class GridImpl : public Grid {
+private:
+	Map::Ptr _map = nullptr;
+	std::vector<bool> _lookup; // Blocking state of small cels, for map grids.
+	Ranges _ranges; // Blocking ranges beyond the lookup, for map grids.
+
+	int _width = 0;
+	int _height = 0;
+	std::vector<Byte> _bits; // For bitfield grids.
+
+public:
+	GridImpl() {
+	}
+	virtual ~GridImpl() override {
+	}
+
+	virtual unsigned type(void) const override {
+		return TYPE();
+	}
+
+	virtual int width(void) const override {
+		if (_map)
+			return _map->width();
+
+		return _width;
+	}
+	virtual int height(void) const override {
+		if (_map)
+			return _map->height();
+
+		return _height;
+	}
+
+	virtual bool get(int x, int y) const override {
+		if (_map) {
+			const int cel = _map->get(x, y);
+			if (cel < 0)
+				return false;
+			if (cel < (int)_lookup.size())
+				return _lookup[cel];
+			for (const Range &range : _ranges) {
+				if (cel >= range.first && cel <= range.second)
+					return true;
+			}
+
+			return false;
+		}
+
+		if (x < 0 || x >= _width || y < 0 || y >= _height)
+			return false;
+
+		const size_t i = (size_t)x + (size_t)y * _width;
+
+		return !!(_bits[i >> 3] & (1 << (i & 7)));
+	}
+	virtual bool set(int x, int y, bool blocked) override {
+		if (_map)
+			return false;
+
+		if (x < 0 || x >= _width || y < 0 || y >= _height)
+			return false;
+
+		const size_t i = (size_t)x + (size_t)y * _width;
+		if (blocked)
+			_bits[i >> 3] |= (Byte)(1 << (i & 7));
+		else
+			_bits[i >> 3] &= (Byte)~(1 << (i & 7));
+
+		return true;
+	}
+
+	virtual bool fromMap(Map::Ptr map, const Ranges &ranges) override {
+		clear();
+
+		if (!map)
+			return false;
+
+		_map = map;
+
+		int size = 0;
+		for (const Range &range : ranges) {
+			const int last = std::max(range.first, range.second);
+			if (last < GRID_CEL_LOOKUP_MAX_COUNT)
+				size = std::max(size, last + 1);
+		}
+		_lookup.resize(size, false);
+		for (Range range : ranges) {
+			if (range.second < range.first)
+				std::swap(range.first, range.second);
+			if (range.second < 0)
+				continue;
+
+			const int first = std::max(range.first, 0);
+			const int last = std::min(range.second, size - 1);
+			for (int i = first; i <= last; ++i)
+				_lookup[i] = true;
+			if (range.second >= size)
+				_ranges.push_back(Range(std::max(first, size), range.second));
+		}
+
+		return true;
+	}
+	virtual bool fromBits(const Byte* bits, size_t len, int width, int height) override {
+		clear();
+
+		if (width <= 0 || height <= 0)
+			return false;
+		if ((long long)width * height > GRID_BITS_MAX_AREA)
+			return false;
+
+		_width = width;
+		_height = height;
+		_bits.resize(((size_t)width * height + 7) / 8, 0);
+		if (bits && len > 0 && !_bits.empty())
+			memcpy(&_bits.front(), bits, std::min(len, _bits.size()));
+
+		return true;
+	}
+
+private:
+	void clear(void) {
+		_map = nullptr;
+		_lookup.clear();
+		_ranges.clear();
+
+		_width = 0;
+		_height = 0;
+		_bits.clear();
+	}
+};
+
+Grid* Grid::create(void) {
+	GridImpl* p = new GridImpl();
+
+	return p;
+}
+
+void Grid::destroy(Grid* ptr) {
+	GridImpl* impl = static_cast<GridImpl*>(ptr);
+	delete impl;
+}
+
+/* ===========================================================================} */
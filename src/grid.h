@@ -0,0 +1,70 @@
+/*
+** Bitty
+**
+** An itty bitty game engine.
+**
+** Copyright (C) 2020 - 2025 Tony Wang, all rights reserved
+**
+** For the latest info, see https://github.com/paladin-t/bitty/
+*/
+
+#ifndef __GRID_H__
+#define __GRID_H__
+
+#include "bitty.h"
+#include "map.h"
+#include "object.h"
+#include <vector>
+
+/*
+** {===========================================================================
+** Grid
+*/
+
+/**
+ * @brief Native collision grid for the walker, raycaster and pathfinder
+ *   algorithms.
+ */
+class Grid : public virtual Object {
+public:
+	typedef std::shared_ptr<Grid> Ptr;
+
+	typedef std::pair<int, int> Range; // Inclusive.
+	typedef std::vector<Range> Ranges;
+
+public:
+	BITTY_CLASS_TYPE('G', 'R', 'D', 'A')
+
+	virtual int width(void) const = 0;
+	virtual int height(void) const = 0;
+
+	/**
+	 * @brief Gets whether the tile at the specific position is blocked;
+	 *   positions out of the grid are not blocked.
+	 */
+	virtual bool get(int x, int y) const = 0;
+	/**
+	 * @brief Sets whether the tile at the specific position is blocked; only
+	 *   works with grids from bitfield.
+	 */
+	virtual bool set(int x, int y, bool blocked) = 0;
+
+	/**
+	 * @brief Binds to a map, cels within the ranges are blocked; the map is
+	 *   read on every query so that edits are reflected immediately.
+	 */
+	virtual bool fromMap(Map::Ptr map, const Ranges &ranges) = 0;
+	/**
+	 * @brief Fills from a bitfield, with one bit per tile in rows, from the
+	 *   least significant bit of each byte; fails if the area is empty or
+	 *   larger than `GRID_BITS_MAX_AREA` tiles.
+	 */
+	virtual bool fromBits(const Byte* bits, size_t len, int width, int height) = 0;
+
+	static Grid* create(void);
+	static void destroy(Grid* ptr);
+};
+
+/* ===========================================================================} */
+
+#endif /* __GRID_H__ */
@@ -36,6 +36,13 @@ private:
 	};
 	typedef std::vector<Sub> Subs;
 
+	struct Chunk {
+		Texture::Ptr texture = nullptr;
+		unsigned long ticks = 0;
+		bool valid = false;
+	};
+	typedef std::vector<Chunk> Chunks;
+
 private:
 	Tiles _tiles;
 	int _tileWidth = 0;
@@ -47,6 +54,10 @@ private:
 	bool _batch = false;
 	mutable unsigned long _ticks = 1;
 	mutable Subs _subs;
+	mutable Chunks _chunks; // Row-major.
+	mutable Math::Vec2i _chunkSize; // In tiles.
+	mutable Math::Vec2i _chunkCount;
+	mutable size_t _chunkBytes = 0;
 
 public:
 	MapImpl(bool batch) : _batch(batch) {
@@ -99,6 +110,11 @@ public:
 	virtual int cleanup(void) override {
 		int result = (int)_subs.size();
 		_subs.clear();
+		for (const Chunk &chunk : _chunks) {
+			if (chunk.texture)
+				++result;
+		}
+		invalidate();
 
 		return result;
 	}
@@ -135,6 +151,8 @@ public:
 			_tileWidth = 0;
 			_tileHeight = 0;
 		}
+
+		invalidate();
 	}
 
 	virtual int width(void) const override {
@@ -204,6 +222,8 @@ public:
 		_width = width;
 		_height = height;
 
+		invalidate();
+
 		return true;
 	}
 	virtual void data(int* buf, size_t len) const override {
@@ -253,6 +273,7 @@ public:
 			if (Math::intersects(sub.area, Math::Vec2i(x, y)))
 				sub.valid = false;
 		}
+		invalidate(x, y);
 
 		return true;
 	}
@@ -360,24 +381,12 @@ public:
 			return;
 
 		const bool batchable = _batch &&
-			(rnd->maxTextureWidth() > 0 && rnd->maxTextureHeight() > 0) &&
-			(_width * _tileWidth <= rnd->maxTextureWidth() && _height * _tileHeight <= rnd->maxTextureHeight()) &&
-			!_tiles.texture->paletted();
+			!_tiles.texture->paletted() &&
+			layout(rnd);
 		if (batchable) {
-			Texture::Ptr batch = sub(rnd, 0, 0, _width, _height);
-			if (batch) {
-				if (scale > 1) {
-					const Math::Recti dstRect = Math::Recti::byXYWH(x * scale, y * scale, _width * _tileWidth * scale, _height * _tileHeight * scale);
-
-					rnd->render(batch.get(), nullptr, &dstRect, nullptr, nullptr, false, false, color, colorChanged, alphaChanged);
-				} else {
-					const Math::Recti dstRect = Math::Recti::byXYWH(x, y, _width * _tileWidth, _height * _tileHeight);
+			render(rnd, x, y, color, colorChanged, alphaChanged, std::max(scale, 1), _ticks++);
 
-					rnd->render(batch.get(), nullptr, &dstRect, nullptr, nullptr, false, false, color, colorChanged, alphaChanged);
-				}
-
-				return;
-			}
+			return;
 		}
 
 		const int beginX = Math::clamp((int)(-x / (float)_tileWidth), 0, _width - 1);
@@ -423,11 +432,15 @@ public:
 		}
 		_cels.shrink_to_fit();
 
+		invalidate();
+
 		return true;
 	}
 	virtual void unload(void) override {
 		_cels.clear();
 		_width = _height = 0;
+
+		invalidate();
 	}
 
 	virtual bool toJson(rapidjson::Value &val, rapidjson::Document &doc) const override {
@@ -553,6 +566,209 @@ public:
 	}
 
 private:
+	/**
+	 * @brief Drops all chunks of the batch cache.
+	 */
+	void invalidate(void) const {
+		_chunks.clear();
+		_chunkSize = Math::Vec2i();
+		_chunkCount = Math::Vec2i();
+		_chunkBytes = 0;
+	}
+	/**
+	 * @brief Marks the chunk that contains the specific cel as dirty.
+	 */
+	void invalidate(int x, int y) const {
+		if (_chunks.empty())
+			return;
+
+		const int i = x / _chunkSize.x;
+		const int j = y / _chunkSize.y;
+		if (i >= _chunkCount.x || j >= _chunkCount.y)
+			return;
+
+		_chunks[i + j * _chunkCount.x].valid = false;
+	}
+	/**
+	 * @brief Prepares the chunk layout of the batch cache.
+	 *
+	 * @return `true` if the map can be rendered by chunks.
+	 */
+	bool layout(class Renderer* rnd) const {
+		const int maxWidth = rnd->maxTextureWidth();
+		const int maxHeight = rnd->maxTextureHeight();
+		if (maxWidth <= 0 || maxHeight <= 0)
+			return false;
+		if (_tileWidth <= 0 || _tileHeight <= 0 || _tileWidth > maxWidth || _tileHeight > maxHeight)
+			return false;
+		if (_width <= 0 || _height <= 0)
+			return false;
+
+		const Math::Vec2i size(
+			std::min(BITTY_MAP_BATCH_CHUNK_SIZE, maxWidth / _tileWidth),
+			std::min(BITTY_MAP_BATCH_CHUNK_SIZE, maxHeight / _tileHeight)
+		);
+		if (!_chunks.empty() && size == _chunkSize)
+			return true;
+
+		invalidate();
+		_chunkSize = size;
+		_chunkCount = Math::Vec2i(
+			(_width + size.x - 1) / size.x,
+			(_height + size.y - 1) / size.y
+		);
+		_chunks.resize((size_t)(_chunkCount.x * _chunkCount.y));
+
+		return true;
+	}
+	/**
+	 * @brief Renders the visible chunks, builds the dirty ones lazily.
+	 */
+	void render(
+		class Renderer* rnd,
+		int x, int y,
+		const Color* color, bool colorChanged, bool alphaChanged,
+		int scale,
+		unsigned long now
+	) const {
+		// Prepare.
+		const int chunkWidth = _chunkSize.x * _tileWidth;
+		const int chunkHeight = _chunkSize.y * _tileHeight;
+		const int viewWidth = (rnd->width() + scale - 1) / scale;
+		const int viewHeight = (rnd->height() + scale - 1) / scale;
+		if (x >= viewWidth || y >= viewHeight || x + _width * _tileWidth <= 0 || y + _height * _tileHeight <= 0)
+			return;
+
+		const int beginX = Math::clamp((int)std::floor(-x / (float)chunkWidth), 0, _chunkCount.x - 1);
+		const int endX = Math::clamp((int)std::floor((viewWidth - x) / (float)chunkWidth), 0, _chunkCount.x - 1);
+		const int beginY = Math::clamp((int)std::floor(-y / (float)chunkHeight), 0, _chunkCount.y - 1);
+		const int endY = Math::clamp((int)std::floor((viewHeight - y) / (float)chunkHeight), 0, _chunkCount.y - 1);
+
+		// Render the visible chunks.
+		for (int j = beginY; j <= endY; ++j) {
+			for (int i = beginX; i <= endX; ++i) {
+				Chunk &chunk = _chunks[i + j * _chunkCount.x];
+				if (!chunk.valid || !chunk.texture) {
+					if (!build(rnd, i, j, chunk))
+						continue;
+				}
+				chunk.ticks = now;
+
+				const Math::Recti dstRect = Math::Recti::byXYWH(
+					(x + i * chunkWidth) * scale, (y + j * chunkHeight) * scale,
+					chunk.texture->width() * scale, chunk.texture->height() * scale
+				);
+
+				rnd->render(chunk.texture.get(), nullptr, &dstRect, nullptr, nullptr, false, false, color, colorChanged, alphaChanged);
+			}
+		}
+
+		// Evict the least recently used chunks out of budget.
+		evict(now);
+	}
+	/**
+	 * @brief Builds a chunk of the batch cache, reuses its texture if possible.
+	 */
+	bool build(class Renderer* rnd, int i, int j, Chunk &chunk) const {
+		// Prepare.
+		const int x = i * _chunkSize.x;
+		const int y = j * _chunkSize.y;
+		const int width = std::min(_chunkSize.x, _width - x);
+		const int height = std::min(_chunkSize.y, _height - y);
+		if (width <= 0 || height <= 0)
+			return false;
+
+		const int pixelWidth = width * _tileWidth;
+		const int pixelHeight = height * _tileHeight;
+		if (!chunk.texture || chunk.texture->width() != pixelWidth || chunk.texture->height() != pixelHeight) {
+			if (chunk.texture) {
+				_chunkBytes -= (size_t)(chunk.texture->width() * chunk.texture->height()) * sizeof(UInt32);
+				chunk.texture = nullptr;
+			}
+
+			Texture::Ptr tex(Texture::create());
+			if (!tex->fromBytes(rnd, Texture::TARGET, nullptr, pixelWidth, pixelHeight, 0, Texture::NEAREST))
+				return false;
+			tex->blend(Texture::BLEND);
+
+			chunk.texture = tex;
+			_chunkBytes += (size_t)(pixelWidth * pixelHeight) * sizeof(UInt32);
+		}
+
+		// Draw the tiles.
+		SDL_Renderer* renderer = (SDL_Renderer*)rnd->pointer();
+		SDL_Texture* tex = (SDL_Texture*)chunk.texture->pointer(rnd);
+		if (!tex)
+			return false;
+
+		SDL_Texture* prev = SDL_GetRenderTarget(renderer);
+		SDL_Rect prevClip;
+		SDL_RenderGetClipRect(renderer, &prevClip);
+		const bool prevClipping = !!SDL_RenderIsClipEnabled(renderer);
+		Uint8 r = 0, g = 0, b = 0, a = 0;
+		SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+
+		SDL_SetRenderTarget(renderer, tex);
+		SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+		SDL_RenderClear(renderer);
+		for (int v = 0; v < height; ++v) {
+			for (int u = 0; u < width; ++u) {
+				Math::Recti area;
+				Texture::Ptr sub = at(x + u, y + v, &area);
+				if (!sub)
+					continue;
+
+				SDL_Texture* subTex = (SDL_Texture*)sub->pointer(rnd);
+				const SDL_Rect srcRect{
+					area.xMin(), area.yMin(),
+					area.width(), area.height()
+				};
+				const SDL_Rect dstRect{
+					u * _tileWidth, v * _tileHeight,
+					_tileWidth, _tileHeight
+				};
+				SDL_RenderCopy(renderer, subTex, &srcRect, &dstRect);
+			}
+		}
+		SDL_SetRenderTarget(renderer, prev);
+		if (prevClipping)
+			SDL_RenderSetClipRect(renderer, &prevClip);
+		SDL_SetRenderDrawColor(renderer, r, g, b, a);
+
+		// Finish.
+		chunk.valid = true;
+
+		return true;
+	}
+	/**
+	 * @brief Releases the least recently used chunks until the cache fits in
+	 *   the memory budget, the ones used by the current frame are kept.
+	 */
+	void evict(unsigned long now) const {
+		if (_chunkBytes <= BITTY_MAP_BATCH_MEMORY_BUDGET)
+			return;
+
+		std::vector<Chunk*> candidates;
+		for (Chunk &chunk : _chunks) {
+			if (chunk.texture && chunk.ticks != now)
+				candidates.push_back(&chunk);
+		}
+		std::sort(
+			candidates.begin(), candidates.end(),
+			[] (const Chunk* left, const Chunk* right) -> bool {
+				return left->ticks < right->ticks;
+			}
+		);
+		for (Chunk* chunk : candidates) {
+			if (_chunkBytes <= BITTY_MAP_BATCH_MEMORY_BUDGET)
+				break;
+
+			_chunkBytes -= (size_t)(chunk->texture->width() * chunk->texture->height()) * sizeof(UInt32);
+			chunk->texture = nullptr;
+			chunk->valid = false;
+		}
+	}
+
 	Texture::Ptr blip(class Renderer* rnd, int x, int y, int width, int height) const {
 		// Prepare.
 		if (!_tiles.texture)
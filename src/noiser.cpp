@@ -9,8 +9,20 @@
 */
 
 #include "noiser.h"
+#include "plus.h"
 #include "../lib/fast_noise/Cpp/FastNoiseLite.h"
 
+/*
+** {===========================================================================
+** Macros and constants
+*/
+
+#ifndef NOISER_PARALLEL_MIN_COUNT
+#	define NOISER_PARALLEL_MIN_COUNT 4096
+#endif /* NOISER_PARALLEL_MIN_COUNT */
+
+/* ===========================================================================} */
+
 /*
 ** {===========================================================================
 ** Noiser
@@ -271,6 +283,46 @@ public:
 		return _generator.GetNoise(pos.x, pos.y, pos.z);
 	}
 
+	virtual void fill(
+		const Math::Recti &rect, const Math::Vec2f &scale, const Math::Vec2f &offset,
+		bool parallel,
+		Single* values
+	) override {
+		const int x0 = rect.xMin();
+		const int y0 = rect.yMin();
+		const int w = rect.width();
+		const int h = rect.height();
+		if (w <= 0 || h <= 0 || !values)
+			return;
+
+		// The generator is only read while sampling, so that rows can be
+		// filled by several threads at a time.
+		auto proc = [this, x0, y0, w, &scale, &offset, values] (int begin, int end) -> void {
+			for (int j = begin; j < end; ++j) {
+				const Real y = offset.y + (y0 + j) * scale.y;
+				Single* row = values + (size_t)j * w;
+				for (int i = 0; i < w; ++i) {
+					const Real x = offset.x + (x0 + i) * scale.x;
+					row[i] = _generator.GetNoise(x, y);
+				}
+			}
+		};
+
+		const int n = Parallel::chunks(h, std::max(NOISER_PARALLEL_MIN_COUNT / w, 1), parallel);
+		if (n > 1) {
+			Parallel::fork(
+				h, n,
+				[&proc] (int, int begin, int end) -> void {
+					proc(begin, end);
+				}
+			);
+
+			return;
+		}
+
+		proc(0, h);
+	}
+
 	virtual void domainWarp(Math::Vec2f &pos) override {
 		Real x = pos.x;
 		Real y = pos.y;
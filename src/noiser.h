@@ -37,6 +37,19 @@ public:
 	virtual Real get(const Math::Vec2f &pos) = 0;
 	virtual Real get(const Math::Vec3f &pos) = 0;
 
+	/**
+	 * @brief Fills 2D noise values of a region in bulk, sampled at `offset +
+	 *   (x, y) * scale` for each point in `rect`; splits rows across threads if
+	 *   `parallel` is true and the region is large enough.
+	 *
+	 * @param[out] values Row-major, `rect.width() * rect.height()` values.
+	 */
+	virtual void fill(
+		const Math::Recti &rect, const Math::Vec2f &scale, const Math::Vec2f &offset,
+		bool parallel,
+		Single* values
+	) = 0;
+
 	virtual void domainWarp(Math::Vec2f &pos) = 0;
 	virtual void domainWarp(Math::Vec3f &pos) = 0;
 
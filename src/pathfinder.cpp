@@ -8,8 +8,216 @@
 ** For the latest info, see https://github.com/paladin-t/bitty/
 */
 
+#include "grid.h"
 #include "pathfinder.h"
+#include "plus.h"
 #include "../lib/micropather/micropather.h"
+#include <queue>
+#include <unordered_map>
+#if BITTY_MULTITHREAD_ENABLED
+#	include <condition_variable>
+#	include <deque>
+#endif /* BITTY_MULTITHREAD_ENABLED */
+
+/*
+** {===========================================================================
+** Macros and constants
+*/
+
+#ifndef PATHFINDER_JUMP_POINT_MAX_AREA
+#	define PATHFINDER_JUMP_POINT_MAX_AREA (1024 * 1024)
+#endif /* PATHFINDER_JUMP_POINT_MAX_AREA */
+
+#ifndef PATHFINDER_FLOW_FIELD_MAX_AREA
+#	define PATHFINDER_FLOW_FIELD_MAX_AREA (1024 * 1024)
+#endif /* PATHFINDER_FLOW_FIELD_MAX_AREA */
+
+#ifndef PATHFINDER_HIERARCHICAL_SECTOR_SIZE
+#	define PATHFINDER_HIERARCHICAL_SECTOR_SIZE 16
+#endif /* PATHFINDER_HIERARCHICAL_SECTOR_SIZE */
+
+/* ===========================================================================} */
+
+/*
+** {===========================================================================
+** Pathfinder workers
+*/
+
+#if BITTY_MULTITHREAD_ENABLED
+/**
+ * @brief Asynchronous requests shared by all pathfinders, solved on the
+ *   shared background workers.
+ */
+class PathfinderWorkers : public NonCopyable {
+private:
+	struct Job {
+		typedef std::shared_ptr<Job> Ptr;
+		typedef std::deque<Ptr> Queue;
+		typedef std::list<Ptr> List;
+
+		unsigned owner = 0;
+		unsigned ticket = 0;
+		Pathfinder::Ptr snapshot = nullptr;
+		Math::Vec2i begin;
+		Math::Vec2i end;
+		Pathfinder::SolvedHandler handler = nullptr;
+		bool canceled = false;
+	};
+
+private:
+	Job::Queue _pending;
+	Job::List _running;
+	unsigned _owner = 0;
+	unsigned _ticket = 0;
+	int _tasks = 0; // Posted but not finished.
+
+	std::mutex _lock;
+	std::condition_variable _idle;
+
+public:
+	PathfinderWorkers() {
+		// Makes sure the shared workers are constructed first, so that they
+		// are destroyed after this object and still run the posted tasks.
+		Parallel::prepare();
+	}
+	~PathfinderWorkers() {
+		std::unique_lock<std::mutex> guard(_lock);
+
+		_pending.clear();
+		_idle.wait(guard, [this] (void) -> bool { return _tasks == 0; });
+	}
+
+	static PathfinderWorkers &instance(void) {
+		static PathfinderWorkers workers;
+
+		return workers;
+	}
+
+	/**
+	 * @brief Gets a new owner ID to identify the requests of a pathfinder,
+	 *   which won't be reused like addresses.
+	 */
+	unsigned owner(void) {
+		std::unique_lock<std::mutex> guard(_lock);
+
+		if (++_owner == 0)
+			++_owner;
+
+		return _owner;
+	}
+	unsigned post(
+		unsigned owner, Pathfinder::Ptr snapshot,
+		const Math::Vec2i &begin, const Math::Vec2i &end,
+		const Pathfinder::SolvedHandler &cb
+	) {
+		Job::Ptr job(new Job());
+		job->owner = owner;
+		job->snapshot = snapshot;
+		job->begin = begin;
+		job->end = end;
+		job->handler = cb;
+
+		{
+			std::unique_lock<std::mutex> guard(_lock);
+
+			if (++_ticket == 0)
+				++_ticket;
+			job->ticket = _ticket;
+			_pending.push_back(job);
+			++_tasks;
+		}
+
+		// Each task solves the front pending job, it does nothing if the job
+		// has been canceled before starting.
+		Parallel::post(std::bind(&PathfinderWorkers::proc, this));
+
+		return job->ticket;
+	}
+	int cancel(unsigned owner, unsigned ticket) {
+		Job::List canceled;
+
+		{
+			std::unique_lock<std::mutex> guard(_lock);
+
+			for (Job::Queue::iterator it = _pending.begin(); it != _pending.end(); ) {
+				Job::Ptr &job = *it;
+				if (job->owner == owner && (ticket == 0 || job->ticket == ticket)) {
+					canceled.push_back(job);
+					it = _pending.erase(it);
+				} else {
+					++it;
+				}
+			}
+			for (Job::Ptr &job : _running) {
+				if (job->owner == owner && (ticket == 0 || job->ticket == ticket) && !job->canceled) {
+					job->canceled = true; // Reported by the worker when it's done.
+					canceled.push_back(nullptr);
+				}
+			}
+		}
+
+		int result = 0;
+		for (Job::Ptr &job : canceled) {
+			if (job && job->handler)
+				job->handler(nullptr);
+			++result;
+		}
+
+		return result;
+	}
+
+private:
+	void proc(void) {
+		Job::Ptr job = nullptr;
+		{
+			std::unique_lock<std::mutex> guard(_lock);
+
+			if (_pending.empty()) {
+				finish();
+
+				return;
+			}
+
+			job = _pending.front();
+			_pending.pop_front();
+			_running.push_back(job);
+		}
+
+		Pathfinder::Result::Ptr result(new Pathfinder::Result());
+		if (job->begin == job->end)
+			result->path.push_back(job->begin);
+		else
+			job->snapshot->solve(job->begin, job->end, Pathfinder::EvaluationHandler(), result->path, &result->cost);
+		job->snapshot = nullptr;
+
+		bool canceled = false;
+		{
+			std::unique_lock<std::mutex> guard(_lock);
+
+			_running.remove(job);
+			canceled = job->canceled;
+		}
+
+		if (job->handler)
+			job->handler(canceled ? nullptr : result);
+
+		std::unique_lock<std::mutex> guard(_lock);
+
+		finish();
+	}
+	/**
+	 * @brief Counts a task as finished, with the lock held; nothing of this
+	 *   object is touched after the lock is released, since the destructor
+	 *   may be waiting for the last one.
+	 */
+	void finish(void) {
+		if (--_tasks == 0)
+			_idle.notify_all();
+	}
+};
+#endif /* BITTY_MULTITHREAD_ENABLED */
+
+/* ===========================================================================} */
 
 /*
 ** {===========================================================================
@@ -28,6 +236,33 @@ private:
 	static_assert(sizeof(Number) * 2 == sizeof(void*), "Wrong size.");
 	static_assert(sizeof(Node) == sizeof(void*), "Wrong size.");
 
+	typedef std::pair<float, int> Open;
+	typedef std::priority_queue<Open, std::vector<Open>, std::greater<Open> > OpenList;
+
+	enum FlowDirections : Byte {
+		FLOW_GOAL = 8,
+		FLOW_NONE = 255
+	};
+
+	struct Exit {
+		int from = -1; // Entrance of this sector, indexed as the matrix.
+		int to = -1; // Entrance of the neighbour sector, indexed as the matrix.
+		float cost = 0;
+
+		Exit() {
+		}
+		Exit(int f, int t, float c) : from(f), to(t), cost(c) {
+		}
+	};
+	struct Sector {
+		typedef std::vector<Sector> Array;
+
+		std::vector<int> entrances; // Indexed as the matrix.
+		std::vector<float> costs; // Between entrances, `entrances.size()` squared.
+		std::vector<Exit> exits;
+		bool dirty = true;
+	};
+
 private:
 	int _west = 0;
 	int _north = 0;
@@ -35,11 +270,28 @@ private:
 	int _south = 0;
 	micropather::MicroPather* _pather = nullptr;
 
+	Modes _mode = DEFAULT;
 	float _diagonalCost = 1.414f;
 
 	float* _matrix = nullptr;
 
 	EvaluationHandler _evaluator = nullptr;
+	const Grid* _grid = nullptr;
+
+	std::vector<float> _costs; // For jump point search, indexed as the matrix.
+	std::vector<int> _parents; // For jump point search.
+	std::vector<bool> _closed; // For jump point search, bitset.
+	OpenList _opened; // For jump point search and flow field.
+
+	std::vector<float> _flowCosts; // For flow field, indexed as the matrix.
+	std::vector<Byte> _flowDirections; // For flow field.
+	std::vector<int> _flowGoals; // For flow field, sorted.
+	std::vector<int> _flowDirty; // For flow field, changed positions since last relaxing.
+
+	typename Sector::Array _sectors; // For hierarchical search, built on demand.
+
+	bool _snapshot = false; // For asynchronous solving.
+	unsigned _owner = 0; // For asynchronous solving, identifies the requests.
 
 public:
 	PathfinderImpl(int w, int n, int e, int s) : _west(w), _north(n), _east(e), _south(s) {
@@ -51,6 +303,9 @@ public:
 		_pather = new micropather::MicroPather(this, 1024);
 	}
 	virtual ~PathfinderImpl() override {
+		if (!_snapshot)
+			cancel(0);
+
 		delete _pather;
 
 		if (_matrix) {
@@ -98,6 +353,8 @@ public:
 			float pass = 0;
 			if (_evaluator) {
 				pass = _evaluator(Math::Vec2i(nx, ny));
+			} else if (_grid && _grid->get(nx, ny)) {
+				pass = -1;
 			} else {
 				if (!get(Math::Vec2i(nx, ny), &pass))
 					pass = 1;
@@ -126,6 +383,13 @@ public:
 		fprintf(stdout, "At (%d, %d).\n", x, y);
 	}
 
+	virtual Modes mode(void) const override {
+		return _mode;
+	}
+	virtual void mode(Modes mode) override {
+		_mode = mode;
+	}
+
 	virtual float diagonalCost(void) const override {
 		return _diagonalCost;
 	}
@@ -160,6 +424,11 @@ public:
 		if (i == -1)
 			return false;
 
+		if (!_flowCosts.empty() && _matrix[i] != cost)
+			_flowDirty.push_back(i);
+		if (!_sectors.empty() && _matrix[i] != cost)
+			invalidate(i);
+
 		_matrix[i] = cost;
 
 		return true;
@@ -171,6 +440,18 @@ public:
 			delete [] _matrix;
 			_matrix = nullptr;
 		}
+
+		_costs.clear();
+		_costs.shrink_to_fit();
+		_parents.clear();
+		_parents.shrink_to_fit();
+		_closed.clear();
+		_closed.shrink_to_fit();
+
+		_sectors.clear();
+		_sectors.shrink_to_fit();
+
+		clearFlow();
 	}
 
 	virtual int solve(
@@ -178,18 +459,218 @@ public:
 		EvaluationHandler eval,
 		Math::Vec2i::List &path, float* cost
 	) override {
+		_evaluator = eval;
+		const int result = solve(begin, end, path, cost);
+		_evaluator = nullptr;
+
+		return result;
+	}
+	virtual int solve(
+		const Math::Vec2i &begin, const Math::Vec2i &end,
+		const Grid* grid,
+		Math::Vec2i::List &path, float* cost
+	) override {
+		_pather->Reset(); // The grid might have been changed since last solving.
+		_grid = grid;
+		const int result = solve(begin, end, path, cost);
+		_grid = nullptr;
+
+		return result;
+	}
+
+	virtual unsigned solveAsync(
+		const Math::Vec2i &begin, const Math::Vec2i &end,
+		const Grid* grid,
+		const SolvedHandler &cb
+	) override {
+		Pathfinder::Ptr snapshot_(snapshot(grid), Pathfinder::destroy);
+
+#if BITTY_MULTITHREAD_ENABLED
+		if (_owner == 0)
+			_owner = PathfinderWorkers::instance().owner();
+
+		return PathfinderWorkers::instance().post(_owner, snapshot_, begin, end, cb);
+#else /* BITTY_MULTITHREAD_ENABLED */
+		static unsigned ticket = 0;
+		if (++ticket == 0)
+			++ticket;
+
+		Result::Ptr result(new Result());
+		if (begin == end)
+			result->path.push_back(begin);
+		else
+			snapshot_->solve(begin, end, EvaluationHandler(), result->path, &result->cost);
+		if (cb)
+			cb(result);
+
+		return ticket;
+#endif /* BITTY_MULTITHREAD_ENABLED */
+	}
+	virtual int cancel(unsigned ticket) override {
+#if BITTY_MULTITHREAD_ENABLED
+		if (_owner == 0)
+			return 0; // Never requested.
+
+		return PathfinderWorkers::instance().cancel(_owner, ticket);
+#else /* BITTY_MULTITHREAD_ENABLED */
+		(void)ticket;
+
+		return 0; // Already solved.
+#endif /* BITTY_MULTITHREAD_ENABLED */
+	}
+
+	virtual bool flow(const Math::Vec2i::List &goals) override {
+		clearFlow();
+
+		const long long area = (long long)width() * height();
+		if (area > PATHFINDER_FLOW_FIELD_MAX_AREA)
+			return false;
+
+		_flowCosts.assign((size_t)area, FLT_MAX);
+		_flowDirections.assign((size_t)area, FLOW_NONE);
+		_opened = OpenList();
+		for (const Math::Vec2i &goal : goals) {
+			const int i = index((int)goal.x, (int)goal.y);
+			if (i == -1)
+				continue;
+
+			_flowGoals.push_back(i);
+			if (!passable(i))
+				continue;
+
+			_flowCosts[i] = 0;
+			_flowDirections[i] = FLOW_GOAL;
+			_opened.push(Open(0.0f, i));
+		}
+		std::sort(_flowGoals.begin(), _flowGoals.end());
+		if (_flowGoals.empty()) {
+			clearFlow();
+
+			return false;
+		}
+
+		relax();
+
+		return true;
+	}
+	virtual bool step(const Math::Vec2i &pos, Math::Vec2i &next, float* cost) override {
+		const int dx[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+		const int dy[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+		next = pos;
+		if (cost)
+			*cost = 0;
+
+		if (_flowCosts.empty())
+			return false;
+
+		repair();
+
+		const int i = index((int)pos.x, (int)pos.y);
+		if (i == -1)
+			return false;
+
+		const Byte dir = _flowDirections[i];
+		if (dir == FLOW_NONE)
+			return false;
+
+		if (dir != FLOW_GOAL)
+			next = Math::Vec2i(pos.x + dx[dir], pos.y + dy[dir]);
+		if (cost)
+			*cost = _flowCosts[i];
+
+		return true;
+	}
+	virtual size_t field(Byte* buf, size_t len) override {
+		if (_flowDirections.empty())
+			return 0;
+		if (!buf)
+			return _flowDirections.size();
+
+		repair();
+
+		const size_t n = std::min(len, _flowDirections.size());
+		memcpy(buf, &_flowDirections.front(), n);
+
+		return n;
+	}
+
+private:
+	PathfinderImpl* snapshot(const Grid* grid) const {
+		PathfinderImpl* result = new PathfinderImpl(_west, _north, _east, _south);
+		result->_mode = _mode;
+		result->_diagonalCost = _diagonalCost;
+		result->_snapshot = true;
+		if (_mode == HIERARCHICAL && !grid)
+			result->_sectors = _sectors;
+
+		if (!_matrix && !grid)
+			return result;
+
+		const int area = width() * height();
+		result->_matrix = new float[area];
+		if (_matrix)
+			memcpy(result->_matrix, _matrix, sizeof(float) * area);
+		else
+			std::fill(result->_matrix, result->_matrix + area, 1.0f);
+		if (grid) {
+			for (int j = _north; j <= _south; ++j) {
+				for (int i = _west; i <= _east; ++i) {
+					if (grid->get(i, j))
+						result->_matrix[index(i, j)] = -1;
+				}
+			}
+		}
+
+		return result;
+	}
+
+	int solve(
+		const Math::Vec2i &begin, const Math::Vec2i &end,
+		Math::Vec2i::List &path, float* cost
+	) {
 		const int bx = (int)begin.x;
 		const int by = (int)begin.y;
 		const int ex = (int)end.x;
 		const int ey = (int)end.y;
 
-		_evaluator = eval;
+		// Pruning by jump points only keeps the optimal paths when a diagonal
+		// step costs no less than a straight one and no more than two.
+		if (_mode == JUMP_POINT && _diagonalCost >= 1 && _diagonalCost <= 2 && (long long)width() * height() <= PATHFINDER_JUMP_POINT_MAX_AREA) {
+			if (_evaluator) {
+				return search(
+					bx, by, ex, ey,
+					[this] (int x, int y) -> bool {
+						return _evaluator(Math::Vec2i(x, y)) > -1e-5;
+					},
+					path, cost
+				);
+			} else if (_grid) {
+				return search(
+					bx, by, ex, ey,
+					[this] (int x, int y) -> bool {
+						return !_grid->get(x, y) && (!_matrix || _matrix[index(x, y)] > -1e-5);
+					},
+					path, cost
+				);
+			} else {
+				return search(
+					bx, by, ex, ey,
+					[this] (int x, int y) -> bool {
+						return !_matrix || _matrix[index(x, y)] > -1e-5;
+					},
+					path, cost
+				);
+			}
+		}
+		if (_mode == HIERARCHICAL && !_evaluator && !_grid)
+			return hierarchical(bx, by, ex, ey, path, cost);
+
 		micropather::MPVector<void*> ret;
 		float tmpcost = 0;
 		int result = _pather->Solve(toNode(bx, by), toNode(ex, ey), &ret, &tmpcost);
 		if (cost)
 			*cost = tmpcost;
-		_evaluator = nullptr;
 
 		for (unsigned i = 0; i < ret.size(); ++i) {
 			void* node = ret[i];
@@ -201,7 +682,745 @@ public:
 		return result;
 	}
 
-private:
+	/**
+	 * @brief Jump point search.
+	 *
+	 * @param[in] passable In form of `bool (int x, int y)`, only invoked for
+	 *   positions in bounds.
+	 */
+	template<typename P> int search(
+		int bx, int by, int ex, int ey,
+		const P &passable,
+		Math::Vec2i::List &path, float* cost
+	) {
+		// Prepare.
+		if (cost)
+			*cost = 0;
+
+		if (bx == ex && by == ey)
+			return micropather::MicroPather::START_END_SAME;
+
+		auto walkable = [this, &passable] (int x, int y) -> bool {
+			if (x < _west || x > _east || y < _north || y > _south)
+				return false;
+
+			return passable(x, y);
+		};
+
+		if (index(bx, by) == -1 || !walkable(ex, ey))
+			return micropather::MicroPather::NO_SOLUTION;
+
+		const int area = width() * height();
+		_costs.assign(area, FLT_MAX);
+		_parents.assign(area, -1);
+		_closed.assign(area, false);
+		_opened = OpenList();
+
+		const float diagonal = _diagonalCost;
+		const float estimation = std::min(diagonal, 2.0f);
+		auto distance = [] (int dx, int dy, float diag) -> float {
+			dx = std::abs(dx);
+			dy = std::abs(dy);
+
+			return (float)std::abs(dx - dy) + diag * std::min(dx, dy);
+		};
+
+		// Search.
+		const int start = index(bx, by);
+		const int goal = index(ex, ey);
+		_costs[start] = 0;
+		_opened.push(Open(distance(ex - bx, ey - by, estimation), start));
+		bool found = false;
+		while (!_opened.empty()) {
+			const int node = _opened.top().second;
+			_opened.pop();
+			if (_closed[node])
+				continue;
+			_closed[node] = true;
+
+			if (node == goal) {
+				found = true;
+
+				break;
+			}
+
+			const int x = node % width() + _west;
+			const int y = node / width() + _north;
+			int dirs[8][2];
+			const int n = neighbours(x, y, _parents[node], walkable, dirs);
+			for (int i = 0; i < n; ++i) {
+				int jx = 0, jy = 0;
+				if (!jump(x, y, dirs[i][0], dirs[i][1], ex, ey, walkable, jx, jy))
+					continue;
+
+				const int jumped = index(jx, jy);
+				if (_closed[jumped])
+					continue;
+
+				const float g = _costs[node] + distance(jx - x, jy - y, diagonal);
+				if (g < _costs[jumped]) {
+					_costs[jumped] = g;
+					_parents[jumped] = node;
+					_opened.push(Open(g + distance(ex - jx, ey - jy, estimation), jumped));
+				}
+			}
+		}
+		_opened = OpenList();
+
+		if (!found)
+			return micropather::MicroPather::NO_SOLUTION;
+
+		// Expand the jump points to steps.
+		Math::Vec2i::List points;
+		for (int node = goal; node != -1; node = _parents[node])
+			points.push_front(Math::Vec2i(node % width() + _west, node / width() + _north));
+		float total = 0;
+		const float costs[2] = { 1, diagonal };
+		Math::Vec2i::List::const_iterator it = points.begin();
+		int x = (int)it->x, y = (int)it->y;
+		path.push_back(Math::Vec2i(x, y));
+		for (++it; it != points.end(); ++it) {
+			const int dx = Math::sign((int)it->x - x);
+			const int dy = Math::sign((int)it->y - y);
+			while (x != (int)it->x || y != (int)it->y) {
+				x += dx;
+				y += dy;
+				path.push_back(Math::Vec2i(x, y));
+				float pass = 1;
+				if (_evaluator)
+					pass = _evaluator(Math::Vec2i(x, y));
+				else if (_matrix)
+					pass = _matrix[index(x, y)];
+				total += costs[dx && dy ? 1 : 0] * std::max(pass, 0.0f);
+			}
+		}
+		if (cost)
+			*cost = total;
+
+		return micropather::MicroPather::SOLVED;
+	}
+	/**
+	 * @brief Gets the pruned neighbour directions of a jump point.
+	 */
+	template<typename W> int neighbours(int x, int y, int parent, const W &walkable, int (&dirs)[8][2]) const {
+		int n = 0;
+		auto add = [&] (int dx, int dy) -> void {
+			dirs[n][0] = dx;
+			dirs[n][1] = dy;
+			++n;
+		};
+
+		if (parent == -1) {
+			for (int j = -1; j <= 1; ++j) {
+				for (int i = -1; i <= 1; ++i) {
+					if ((i || j) && walkable(x + i, y + j))
+						add(i, j);
+				}
+			}
+
+			return n;
+		}
+
+		const int dx = Math::sign(x - (parent % width() + _west));
+		const int dy = Math::sign(y - (parent / width() + _north));
+		if (dx && dy) {
+			add(dx, 0);
+			add(0, dy);
+			add(dx, dy);
+			if (!walkable(x - dx, y))
+				add(-dx, dy);
+			if (!walkable(x, y - dy))
+				add(dx, -dy);
+		} else if (dx) {
+			add(dx, 0);
+			if (!walkable(x, y + 1))
+				add(dx, 1);
+			if (!walkable(x, y - 1))
+				add(dx, -1);
+		} else {
+			add(0, dy);
+			if (!walkable(x + 1, y))
+				add(1, dy);
+			if (!walkable(x - 1, y))
+				add(-1, dy);
+		}
+
+		return n;
+	}
+	/**
+	 * @brief Jumps from a position in the specific direction.
+	 *
+	 * @param[out] jx
+	 * @param[out] jy
+	 * @return `true` if a jump point has been found.
+	 */
+	template<typename W> static bool jump(int x, int y, int dx, int dy, int ex, int ey, const W &walkable, int &jx, int &jy) {
+		if (!dx || !dy) {
+			if (!straight(x, y, dx, dy, ex, ey, walkable))
+				return false;
+
+			jx = x;
+			jy = y;
+
+			return true;
+		}
+
+		for (; ; ) {
+			x += dx;
+			y += dy;
+			if (!walkable(x, y))
+				return false;
+			if (x == ex && y == ey)
+				break;
+			if ((walkable(x - dx, y + dy) && !walkable(x - dx, y)) || (walkable(x + dx, y - dy) && !walkable(x, y - dy)))
+				break;
+
+			int sx = x, sy = y;
+			if (straight(sx, sy, dx, 0, ex, ey, walkable))
+				break;
+			sx = x, sy = y;
+			if (straight(sx, sy, 0, dy, ex, ey, walkable))
+				break;
+		}
+		jx = x;
+		jy = y;
+
+		return true;
+	}
+	/**
+	 * @brief Jumps horizontally or vertically.
+	 *
+	 * @param[in, out] x
+	 * @param[in, out] y
+	 * @return `true` if a jump point has been found.
+	 */
+	template<typename W> static bool straight(int &x, int &y, int dx, int dy, int ex, int ey, const W &walkable) {
+		for (; ; ) {
+			x += dx;
+			y += dy;
+			if (!walkable(x, y))
+				return false;
+			if (x == ex && y == ey)
+				return true;
+			if (dx) {
+				if ((walkable(x + dx, y + 1) && !walkable(x, y + 1)) || (walkable(x + dx, y - 1) && !walkable(x, y - 1)))
+					return true;
+			} else {
+				if ((walkable(x + 1, y + dy) && !walkable(x + 1, y)) || (walkable(x - 1, y + dy) && !walkable(x - 1, y)))
+					return true;
+			}
+		}
+	}
+
+	/**
+	 * @brief Hierarchical search; searches over the entrances between sectors
+	 *   first, then refines each abstract step within its sector.
+	 */
+	int hierarchical(
+		int bx, int by, int ex, int ey,
+		Math::Vec2i::List &path, float* cost
+	) {
+		// Prepare.
+		if (cost)
+			*cost = 0;
+
+		if (bx == ex && by == ey)
+			return micropather::MicroPather::START_END_SAME;
+
+		const int start = index(bx, by);
+		const int goal = index(ex, ey);
+		if (start == -1 || goal == -1 || !passable(goal))
+			return micropather::MicroPather::NO_SOLUTION;
+
+		if (_sectors.empty())
+			_sectors.resize(sectorCountX() * sectorCountY());
+
+		const int startSector = sectorOf(start);
+		const int goalSector = sectorOf(goal);
+		build(startSector);
+		build(goalSector);
+
+		std::vector<float> forward, backward;
+		std::vector<int> parents;
+		sweep(startSector, start, false, -1, forward, parents);
+		sweep(goalSector, goal, true, -1, backward, parents);
+
+		const float diagonal = _diagonalCost;
+		const float estimation = diagonal < 0 ? 2.0f : std::min(diagonal, 2.0f);
+		auto distance = [this, goal, estimation] (int node) -> float {
+			const int dx = std::abs(node % width() - goal % width());
+			const int dy = std::abs(node / width() - goal / width());
+
+			return (float)std::abs(dx - dy) + estimation * std::min(dx, dy);
+		};
+
+		// Search over the entrances.
+		std::unordered_map<int, std::pair<float, int> > visited; // Cost and parent.
+		OpenList opened;
+		visited[start] = std::make_pair(0.0f, -1);
+		opened.push(Open(distance(start), start));
+		bool found = false;
+		while (!opened.empty()) {
+			const Open top = opened.top();
+			opened.pop();
+			const int node = top.second;
+			const float g = visited[node].first;
+			if (top.first > g + distance(node)) // Outdated.
+				continue;
+
+			if (node == goal) {
+				found = true;
+
+				break;
+			}
+
+			auto open = [&] (int next, float c) -> void {
+				if (c >= FLT_MAX)
+					return;
+
+				const float h = g + c;
+				typename std::unordered_map<int, std::pair<float, int> >::iterator it = visited.find(next);
+				if (it != visited.end() && it->second.first <= h)
+					return;
+
+				visited[next] = std::make_pair(h, node);
+				opened.push(Open(h + distance(next), next));
+			};
+
+			const int sector = sectorOf(node);
+			build(sector);
+			const Sector &sec = _sectors[sector];
+			const int n = (int)sec.entrances.size();
+			const int k = (int)(std::find(sec.entrances.begin(), sec.entrances.end(), node) - sec.entrances.begin());
+			if (node == start) {
+				for (int j = 0; j < n; ++j)
+					open(sec.entrances[j], forward[local(sector, sec.entrances[j])]);
+				if (sector == goalSector)
+					open(goal, forward[local(sector, goal)]);
+			} else if (k < n) {
+				for (int j = 0; j < n; ++j) {
+					if (j != k)
+						open(sec.entrances[j], sec.costs[k * n + j]);
+				}
+				if (sector == goalSector)
+					open(goal, backward[local(sector, node)]);
+			}
+			if (k < n) {
+				for (const Exit &exit : sec.exits) {
+					if (exit.from == node)
+						open(exit.to, exit.cost);
+				}
+			}
+		}
+
+		if (!found)
+			return micropather::MicroPather::NO_SOLUTION;
+
+		// Refine the abstract steps within sectors.
+		std::vector<int> steps;
+		for (int node = goal; node != -1; node = visited[node].second)
+			steps.push_back(node);
+		std::reverse(steps.begin(), steps.end());
+
+		const int w = width();
+		float total = 0;
+		path.push_back(Math::Vec2i(start % w + _west, start / w + _north));
+		for (int i = 1; i < (int)steps.size(); ++i) {
+			const int from = steps[i - 1];
+			const int to = steps[i];
+			const int sector = sectorOf(from);
+			Math::Vec2i::List::iterator it = path.end();
+			if (sector == sectorOf(to)) {
+				sweep(sector, from, false, to, forward, parents);
+				for (int node = to; node != from; node = parents[local(sector, node)])
+					it = path.insert(it, Math::Vec2i(node % w + _west, node / w + _north));
+			} else {
+				path.push_back(Math::Vec2i(to % w + _west, to / w + _north));
+			}
+		}
+		Math::Vec2i::List::const_iterator it = path.begin();
+		int x = (int)it->x, y = (int)it->y;
+		for (++it; it != path.end(); ++it) {
+			const bool diag = x != (int)it->x && y != (int)it->y;
+			x = (int)it->x;
+			y = (int)it->y;
+			total += (diag ? diagonal : 1.0f) * weight(index(x, y));
+		}
+		if (cost)
+			*cost = total;
+
+		return micropather::MicroPather::SOLVED;
+	}
+	/**
+	 * @brief Dijkstra within a sector; forward from a position, or backward
+	 *   toward it.
+	 *
+	 * @param[out] costs Indexed by `local(...)`.
+	 * @param[out] parents Indexed by `local(...)`.
+	 */
+	void sweep(int sector, int from, bool backward, int to, std::vector<float> &costs, std::vector<int> &parents) const {
+		constexpr const int S = PATHFINDER_HIERARCHICAL_SECTOR_SIZE;
+		const int dx[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+		const int dy[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+		const float cost[8] = { 1, _diagonalCost, 1, _diagonalCost, 1, _diagonalCost, 1, _diagonalCost };
+
+		int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+		bounds(sector, x0, y0, x1, y1);
+		const int w = width();
+		const int sw = x1 - x0 + 1;
+		const int sh = y1 - y0 + 1;
+
+		float weights[S * S]; // Negative for blocked.
+		for (int y = 0; y < sh; ++y) {
+			for (int x = 0; x < sw; ++x) {
+				const int i = (x0 + x) + (y0 + y) * w;
+				weights[x + y * S] = passable(i) ? weight(i) : -1;
+			}
+		}
+
+		costs.assign(S * S, FLT_MAX);
+		parents.assign(S * S, -1);
+		std::vector<Open> opened; // Heap of local indices.
+		opened.reserve(S * S);
+		const int begin = local(sector, from);
+		const int end = to == -1 ? -1 : local(sector, to);
+		costs[begin] = 0;
+		opened.push_back(Open(0.0f, begin));
+		while (!opened.empty()) {
+			std::pop_heap(opened.begin(), opened.end(), std::greater<Open>());
+			const Open top = opened.back();
+			opened.pop_back();
+			const int node = top.second;
+			if (top.first > costs[node]) // Outdated.
+				continue;
+			if (node == end)
+				break;
+
+			const int x = node % S;
+			const int y = node / S;
+			for (int i = 0; i < 8; ++i) {
+				if (cost[i] < -1e-5)
+					continue;
+
+				const int nx = x + dx[i];
+				const int ny = y + dy[i];
+				if (nx < 0 || nx >= sw || ny < 0 || ny >= sh)
+					continue;
+
+				const int n = nx + ny * S;
+				if (weights[n] < 0)
+					continue;
+
+				const float c = top.first + cost[i] * weights[backward ? node : n];
+				if (c < costs[n]) {
+					costs[n] = c;
+					parents[n] = (x0 + x) + (y0 + y) * w;
+					opened.push_back(Open(c, n));
+					std::push_heap(opened.begin(), opened.end(), std::greater<Open>());
+				}
+			}
+		}
+	}
+	/**
+	 * @brief Builds the entrances and the costs between them for a sector if
+	 *   it's dirty.
+	 */
+	void build(int sector) {
+		Sector &sec = _sectors[sector];
+		if (!sec.dirty)
+			return;
+
+		sec.entrances.clear();
+		sec.costs.clear();
+		sec.exits.clear();
+
+		const int sx = sector % sectorCountX();
+		const int sy = sector / sectorCountX();
+		for (int j = -1; j <= 1; ++j) {
+			for (int i = -1; i <= 1; ++i) {
+				if (!i && !j)
+					continue;
+				if (sx + i < 0 || sx + i >= sectorCountX() || sy + j < 0 || sy + j >= sectorCountY())
+					continue;
+
+				border(sector, sector + i + j * sectorCountX(), sec.exits);
+			}
+		}
+		for (const Exit &exit : sec.exits) {
+			if (std::find(sec.entrances.begin(), sec.entrances.end(), exit.from) == sec.entrances.end())
+				sec.entrances.push_back(exit.from);
+		}
+
+		const int n = (int)sec.entrances.size();
+		std::vector<float> costs;
+		std::vector<int> parents;
+		sec.costs.resize(n * n);
+		for (int i = 0; i < n; ++i) {
+			sweep(sector, sec.entrances[i], false, -1, costs, parents);
+			for (int j = 0; j < n; ++j)
+				sec.costs[i * n + j] = costs[local(sector, sec.entrances[j])];
+		}
+
+		sec.dirty = false;
+	}
+	/**
+	 * @brief Collects the crossings from a sector to its neighbour; straight
+	 *   crossings are merged by runs along the border, diagonal ones are kept
+	 *   only if there's no straight way around.
+	 */
+	void border(int sector, int neighbour, std::vector<Exit> &exits) const {
+		const float diagonal = _diagonalCost;
+		const int w = width();
+		int x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+		bounds(sector, x0, y0, x1, y1);
+		int nx0 = 0, ny0 = 0, nx1 = 0, ny1 = 0;
+		bounds(neighbour, nx0, ny0, nx1, ny1);
+		const int dx = Math::sign(nx0 - x0);
+		const int dy = Math::sign(ny0 - y0);
+
+		auto pass = [this, w] (int x, int y) -> bool {
+			return passable(x + y * w);
+		};
+		auto add = [this, w, &exits] (int x, int y, int nx, int ny, float step) -> void {
+			const int to = nx + ny * w;
+			exits.push_back(Exit(x + y * w, to, step * weight(to)));
+		};
+
+		if (dx && dy) { // Corner.
+			if (diagonal < 0)
+				return;
+
+			const int x = dx > 0 ? x1 : x0;
+			const int y = dy > 0 ? y1 : y0;
+			if (pass(x, y) && pass(x + dx, y + dy) && !pass(x + dx, y) && !pass(x, y + dy))
+				add(x, y, x + dx, y + dy, diagonal);
+
+			return;
+		}
+
+		// Walk along the border, with `u` across it and `v` along it.
+		const int u = dx > 0 ? x1 : dx < 0 ? x0 : dy > 0 ? y1 : y0;
+		const int du = dx ? dx : dy;
+		const int v0 = dx ? y0 : x0;
+		const int v1 = dx ? y1 : x1;
+		auto at = [dx] (int u, int v, int &x, int &y) -> void {
+			if (dx) {
+				x = u;
+				y = v;
+			} else {
+				x = v;
+				y = u;
+			}
+		};
+		auto crossable = [&] (int v) -> bool {
+			int ax = 0, ay = 0, bx = 0, by = 0;
+			at(u, v, ax, ay);
+			at(u + du, v, bx, by);
+
+			return pass(ax, ay) && pass(bx, by);
+		};
+		auto cross = [&] (int v, int nv, float step) -> void {
+			int ax = 0, ay = 0, bx = 0, by = 0;
+			at(u, v, ax, ay);
+			at(u + du, nv, bx, by);
+			add(ax, ay, bx, by, step);
+		};
+
+		for (int v = v0; v <= v1; ) { // Straight runs, the same for both sides.
+			if (!crossable(v)) {
+				++v;
+
+				continue;
+			}
+
+			int end = v;
+			while (end + 1 <= v1 && crossable(end + 1))
+				++end;
+			if (end - v + 1 < 6) {
+				cross((v + end) / 2, (v + end) / 2, 1);
+			} else {
+				cross(v, v, 1);
+				cross(end, end, 1);
+			}
+			v = end + 1;
+		}
+		if (diagonal < 0)
+			return;
+
+		for (int v = v0; v < v1; ++v) { // Diagonal crossings.
+			int ax = 0, ay = 0, bx = 0, by = 0, cx = 0, cy = 0, ex = 0, ey = 0;
+			at(u, v, ax, ay);
+			at(u, v + 1, bx, by);
+			at(u + du, v, cx, cy);
+			at(u + du, v + 1, ex, ey);
+			const bool a = pass(ax, ay), b = pass(bx, by), c = pass(cx, cy), e = pass(ex, ey);
+			if (a && e && !b && !c)
+				cross(v, v + 1, diagonal);
+			else if (b && c && !a && !e)
+				cross(v + 1, v, diagonal);
+		}
+	}
+	/**
+	 * @brief Marks the sector of a changed position and its neighbours dirty,
+	 *   since the crossings on the borders might have been changed.
+	 */
+	void invalidate(int i) {
+		const int sx = (i % width()) / PATHFINDER_HIERARCHICAL_SECTOR_SIZE;
+		const int sy = (i / width()) / PATHFINDER_HIERARCHICAL_SECTOR_SIZE;
+		for (int y = std::max(sy - 1, 0); y <= std::min(sy + 1, sectorCountY() - 1); ++y) {
+			for (int x = std::max(sx - 1, 0); x <= std::min(sx + 1, sectorCountX() - 1); ++x)
+				_sectors[x + y * sectorCountX()].dirty = true;
+		}
+	}
+	int sectorCountX(void) const {
+		return (width() + PATHFINDER_HIERARCHICAL_SECTOR_SIZE - 1) / PATHFINDER_HIERARCHICAL_SECTOR_SIZE;
+	}
+	int sectorCountY(void) const {
+		return (height() + PATHFINDER_HIERARCHICAL_SECTOR_SIZE - 1) / PATHFINDER_HIERARCHICAL_SECTOR_SIZE;
+	}
+	int sectorOf(int i) const {
+		const int sx = (i % width()) / PATHFINDER_HIERARCHICAL_SECTOR_SIZE;
+		const int sy = (i / width()) / PATHFINDER_HIERARCHICAL_SECTOR_SIZE;
+
+		return sx + sy * sectorCountX();
+	}
+	/**
+	 * @brief Gets the bounds of a sector, inclusive, relative to the west and
+	 *   north edges.
+	 */
+	void bounds(int sector, int &x0, int &y0, int &x1, int &y1) const {
+		x0 = (sector % sectorCountX()) * PATHFINDER_HIERARCHICAL_SECTOR_SIZE;
+		y0 = (sector / sectorCountX()) * PATHFINDER_HIERARCHICAL_SECTOR_SIZE;
+		x1 = std::min(x0 + PATHFINDER_HIERARCHICAL_SECTOR_SIZE, width()) - 1;
+		y1 = std::min(y0 + PATHFINDER_HIERARCHICAL_SECTOR_SIZE, height()) - 1;
+	}
+	int local(int sector, int i) const {
+		const int x = i % width() - (sector % sectorCountX()) * PATHFINDER_HIERARCHICAL_SECTOR_SIZE;
+		const int y = i / width() - (sector / sectorCountX()) * PATHFINDER_HIERARCHICAL_SECTOR_SIZE;
+
+		return x + y * PATHFINDER_HIERARCHICAL_SECTOR_SIZE;
+	}
+
+	bool passable(int i) const {
+		return !_matrix || _matrix[i] > -1e-5;
+	}
+	float weight(int i) const {
+		return _matrix ? std::max(_matrix[i], 0.0f) : 1.0f;
+	}
+
+	void clearFlow(void) {
+		_flowCosts.clear();
+		_flowCosts.shrink_to_fit();
+		_flowDirections.clear();
+		_flowDirections.shrink_to_fit();
+		_flowGoals.clear();
+		_flowDirty.clear();
+	}
+	/**
+	 * @brief Relaxes the flow field from the opened positions, backward from
+	 *   the goals; a position might be opened more than once.
+	 */
+	void relax(void) {
+		const int dx[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+		const int dy[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+		const float cost[8] = { 1, _diagonalCost, 1, _diagonalCost, 1, _diagonalCost, 1, _diagonalCost };
+
+		while (!_opened.empty()) {
+			const Open top = _opened.top();
+			_opened.pop();
+			const int node = top.second;
+			if (top.first > _flowCosts[node]) // Outdated.
+				continue;
+
+			const int x = node % width() + _west;
+			const int y = node / width() + _north;
+			float pass = 1;
+			if (_matrix)
+				pass = std::max(_matrix[node], 0.0f);
+			for (int i = 0; i < 8; ++i) {
+				if (cost[i] < -1e-5)
+					continue;
+
+				const int n = index(x - dx[i], y - dy[i]); // The neighbour which steps into this node in the direction.
+				if (n == -1 || !passable(n) || _flowDirections[n] == FLOW_GOAL)
+					continue;
+
+				const float c = top.first + cost[i] * pass;
+				if (c < _flowCosts[n]) {
+					_flowCosts[n] = c;
+					_flowDirections[n] = (Byte)i;
+					_opened.push(Open(c, n));
+				}
+			}
+		}
+	}
+	/**
+	 * @brief Repairs the flow field for the changed positions; drops the
+	 *   positions whose path goes through a changed one, then relaxes them
+	 *   again from the unaffected neighbours.
+	 */
+	void repair(void) {
+		const int dx[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+		const int dy[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+		if (_flowDirty.empty())
+			return;
+
+		// Drop the affected positions.
+		std::vector<int> affected;
+		std::vector<int> stack;
+		_opened = OpenList();
+		for (int i : _flowDirty) {
+			if (std::binary_search(_flowGoals.begin(), _flowGoals.end(), i) && passable(i)) {
+				_flowCosts[i] = 0;
+				_flowDirections[i] = FLOW_GOAL;
+				_opened.push(Open(0.0f, i));
+			} else {
+				_flowCosts[i] = FLT_MAX;
+				_flowDirections[i] = FLOW_NONE;
+				affected.push_back(i);
+			}
+			stack.push_back(i);
+		}
+		_flowDirty.clear();
+		while (!stack.empty()) {
+			const int node = stack.back();
+			stack.pop_back();
+			const int x = node % width() + _west;
+			const int y = node / width() + _north;
+			for (int i = 0; i < 8; ++i) {
+				const int n = index(x + dx[i], y + dy[i]);
+				if (n == -1)
+					continue;
+
+				const Byte dir = _flowDirections[n];
+				if (dir == FLOW_NONE || dir == FLOW_GOAL)
+					continue;
+				if (dx[dir] != -dx[i] || dy[dir] != -dy[i]) // Doesn't step into this node.
+					continue;
+
+				_flowCosts[n] = FLT_MAX;
+				_flowDirections[n] = FLOW_NONE;
+				affected.push_back(n);
+				stack.push_back(n);
+			}
+		}
+
+		// Relax from the boundary.
+		for (int node : affected) {
+			const int x = node % width() + _west;
+			const int y = node / width() + _north;
+			for (int i = 0; i < 8; ++i) {
+				const int n = index(x + dx[i], y + dy[i]);
+				if (n == -1 || _flowDirections[n] == FLOW_NONE)
+					continue;
+
+				_opened.push(Open(_flowCosts[n], n));
+			}
+		}
+		relax();
+	}
+
 	int width(void) const {
 		return _east - _west + 1;
 	}
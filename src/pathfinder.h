@@ -29,9 +29,36 @@ public:
 
 	typedef std::function<float(const Math::Vec2i &)> EvaluationHandler;
 
+	/**
+	 * @brief Result of asynchronous solving.
+	 */
+	struct Result : public virtual Object {
+		typedef std::shared_ptr<Result> Ptr;
+
+		BITTY_CLASS_TYPE('P', 'T', 'H', 'S')
+
+		Math::Vec2i::List path;
+		float cost = 0;
+
+		virtual unsigned type(void) const override {
+			return TYPE();
+		}
+	};
+
+	typedef std::function<void(Result::Ptr /* nullable */)> SolvedHandler;
+
+	enum Modes {
+		DEFAULT,
+		JUMP_POINT, // For uniform-cost grids, tile costs only decide whether it's walkable; requires diagonal cost in [1, 2].
+		HIERARCHICAL // For large grids, searches over sector entrances then refines within sectors; near optimal.
+	};
+
 public:
 	BITTY_CLASS_TYPE('P', 'T', 'H', 'R')
 
+	virtual Modes mode(void) const = 0;
+	virtual void mode(Modes mode) = 0;
+
 	virtual float diagonalCost(void) const = 0;
 	virtual void diagonalCost(float cost) = 0;
 
@@ -52,6 +79,64 @@ public:
 		EvaluationHandler eval /* nullable */,
 		Math::Vec2i::List &path, float* cost /* nullable */
 	) = 0;
+	/**
+	 * @brief Blocked tiles of the grid are impassable, the others cost as the
+	 *   matrix.
+	 *
+	 * @param[out] path
+	 * @param[out] cost
+	 */
+	virtual int solve(
+		const Math::Vec2i &begin, const Math::Vec2i &end,
+		const class Grid* grid,
+		Math::Vec2i::List &path, float* cost /* nullable */
+	) = 0;
+
+	/**
+	 * @brief Solves on a snapshot of the matrix with the background workers,
+	 *   pending requests run in parallel; blocked tiles of the grid are baked
+	 *   into the snapshot.
+	 *
+	 * @param[in] cb Called on a worker thread with the result, or with
+	 *   `nullptr` if the request is canceled, which might happen on the thread
+	 *   that cancels; it shouldn't touch anything owned by the caller's thread.
+	 * @return The ticket of the request.
+	 */
+	virtual unsigned solveAsync(
+		const Math::Vec2i &begin, const Math::Vec2i &end,
+		const class Grid* grid /* nullable */,
+		const SolvedHandler &cb
+	) = 0;
+	/**
+	 * @brief Cancels the specific asynchronous request, or all pending ones of
+	 *   this pathfinder if `ticket` is 0.
+	 *
+	 * @return The count of the canceled requests.
+	 */
+	virtual int cancel(unsigned ticket) = 0;
+
+	/**
+	 * @brief Computes a flow field toward the nearest goal over the cost
+	 *   matrix, it's updated incrementally when the matrix changes.
+	 */
+	virtual bool flow(const Math::Vec2i::List &goals) = 0;
+	/**
+	 * @brief Gets the next step toward the nearest goal from the flow field.
+	 *
+	 * @param[out] next
+	 * @param[out] cost The remaining cost.
+	 */
+	virtual bool step(const Math::Vec2i &pos, Math::Vec2i &next, float* cost /* nullable */) = 0;
+	/**
+	 * @brief Gets the directions of the flow field, one byte per position in
+	 *   rows; 0 to 7 for east, south-east, south, south-west, west, north-west,
+	 *   north, north-east, 8 for goal, 255 for unreachable.
+	 *
+	 * @param[out] buf
+	 * @return The count of the written bytes, or the required size if `buf`
+	 *   is `nullptr`.
+	 */
+	virtual size_t field(Byte* buf, size_t len) = 0;
 
 	static Pathfinder* create(int w, int n, int e, int s);
 	static void destroy(Pathfinder* ptr);
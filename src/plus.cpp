@@ -9,10 +9,204 @@
 */
 
 #include "plus.h"
+#include <algorithm>
+#if BITTY_MULTITHREAD_ENABLED
+#	include <condition_variable>
+#	include <deque>
+#	include <thread>
+#	include <vector>
+#endif /* BITTY_MULTITHREAD_ENABLED */
+
+/*
+** {===========================================================================
+** Macros and constants
+*/
+
+#ifndef PLUS_WORKER_MAX_COUNT
+#	define PLUS_WORKER_MAX_COUNT 8
+#endif /* PLUS_WORKER_MAX_COUNT */
+
+/* ===========================================================================} */
 
 /*
 ** {===========================================================================
 ** C++ utilities
 */
 
+#if BITTY_MULTITHREAD_ENABLED
+class Workers : public NonCopyable {
+private:
+	struct Fork {
+		typedef std::shared_ptr<Fork> Ptr;
+
+		const Parallel::Proc* proc = nullptr; // Foreign, only touched for the taken chunks.
+		int count = 0;
+		int chunks = 0;
+		int size = 0;
+		std::atomic<int> next { 0 };
+		int done = 0;
+
+		std::mutex lock;
+		std::condition_variable signal;
+
+		void run(void) {
+			for (; ; ) {
+				const int i = next++;
+				if (i >= chunks)
+					break;
+
+				const int begin = std::min(i * size, count);
+				const int end = std::min(begin + size, count);
+				(*proc)(i, begin, end);
+
+				std::unique_lock<std::mutex> guard(lock);
+
+				if (++done == chunks)
+					signal.notify_all();
+			}
+		}
+	};
+
+private:
+	std::vector<std::thread> _threads;
+	std::deque<Parallel::Task> _tasks;
+	bool _quit = false;
+
+	std::mutex _lock;
+	std::condition_variable _signal;
+
+public:
+	~Workers() {
+		{
+			std::unique_lock<std::mutex> guard(_lock);
+
+			_quit = true;
+			_tasks.clear();
+		}
+		_signal.notify_all();
+
+		for (std::thread &thread : _threads) {
+			if (thread.joinable())
+				thread.join();
+		}
+		_threads.clear();
+	}
+
+	static Workers &instance(void) {
+		static Workers workers;
+
+		return workers;
+	}
+
+	static int count(void) {
+		return std::max(std::min((int)std::thread::hardware_concurrency() - 1, PLUS_WORKER_MAX_COUNT), 1);
+	}
+
+	void post(const Parallel::Task &task) {
+		{
+			std::unique_lock<std::mutex> guard(_lock);
+
+			if (_threads.empty()) {
+				const int n = count();
+				for (int i = 0; i < n; ++i)
+					_threads.push_back(std::thread(&Workers::proc, this));
+			}
+
+			_tasks.push_back(task);
+		}
+		_signal.notify_one();
+	}
+	void fork(int count, int chunks, const Parallel::Proc &proc) {
+		Fork::Ptr fork(new Fork());
+		fork->proc = &proc;
+		fork->count = count;
+		fork->chunks = chunks;
+		fork->size = (count + chunks - 1) / chunks;
+
+		// The tasks that start after all chunks are taken return immediately.
+		for (int i = 1; i < chunks; ++i) {
+			post(
+				[fork] (void) -> void {
+					fork->run();
+				}
+			);
+		}
+		fork->run();
+
+		std::unique_lock<std::mutex> guard(fork->lock);
+		fork->signal.wait(guard, [&fork] (void) -> bool { return fork->done == fork->chunks; });
+	}
+
+private:
+	void proc(void) {
+		for (; ; ) {
+			Parallel::Task task = nullptr;
+			{
+				std::unique_lock<std::mutex> guard(_lock);
+
+				_signal.wait(guard, [this] (void) -> bool { return _quit || !_tasks.empty(); });
+				if (_quit)
+					break;
+
+				task = _tasks.front();
+				_tasks.pop_front();
+			}
+
+			task();
+		}
+	}
+};
+#endif /* BITTY_MULTITHREAD_ENABLED */
+
+int Parallel::workers(void) {
+#if BITTY_MULTITHREAD_ENABLED
+	return Workers::count();
+#else /* BITTY_MULTITHREAD_ENABLED */
+	return 0;
+#endif /* BITTY_MULTITHREAD_ENABLED */
+}
+
+void Parallel::prepare(void) {
+#if BITTY_MULTITHREAD_ENABLED
+	Workers::instance();
+#endif /* BITTY_MULTITHREAD_ENABLED */
+}
+
+bool Parallel::post(const Task &task) {
+#if BITTY_MULTITHREAD_ENABLED
+	Workers::instance().post(task);
+
+	return true;
+#else /* BITTY_MULTITHREAD_ENABLED */
+	(void)task;
+
+	return false;
+#endif /* BITTY_MULTITHREAD_ENABLED */
+}
+
+int Parallel::chunks(int count, int grain, bool parallel) {
+	if (!parallel || grain <= 0)
+		return 1;
+
+	return std::max(std::min(count / grain, workers() + 1), 1);
+}
+
+void Parallel::fork(int count, int chunks, const Proc &proc) {
+	if (count <= 0)
+		return;
+
+#if BITTY_MULTITHREAD_ENABLED
+	chunks = std::min(chunks, count);
+	if (chunks > 1) {
+		Workers::instance().fork(count, chunks, proc);
+
+		return;
+	}
+#else /* BITTY_MULTITHREAD_ENABLED */
+	(void)chunks;
+#endif /* BITTY_MULTITHREAD_ENABLED */
+
+	proc(0, 0, count);
+}
+
 /* ===========================================================================} */
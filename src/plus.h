@@ -284,6 +284,49 @@ public:
 	}
 };
 
+/**
+ * @brief Parallel utilities on the background workers shared by the
+ *   application, threads are started on the first task.
+ */
+class Parallel {
+public:
+	typedef std::function<void(void)> Task;
+	typedef std::function<void(int /* chunk */, int /* begin */, int /* end */)> Proc;
+
+public:
+	/**
+	 * @brief Gets the count of the worker threads, 0 without multithreading.
+	 */
+	static int workers(void);
+	/**
+	 * @brief Makes sure the shared workers are constructed; call it from the
+	 *   constructor of a static object which posts tasks, so that the workers
+	 *   are destroyed after that object.
+	 */
+	static void prepare(void);
+	/**
+	 * @brief Queues a task to run on a worker thread.
+	 *
+	 * @return `false` without multithreading.
+	 */
+	static bool post(const Task &task);
+
+	/**
+	 * @brief Gets the count of chunks to split the specific count of items
+	 *   into, with at least `grain` items per chunk; 1 if not parallel.
+	 */
+	static int chunks(int count, int grain, bool parallel = true);
+	/**
+	 * @brief Splits `[0, count)` into the specific count of chunks, and runs
+	 *   `proc(chunk, begin, end)` for each of them on the workers and the
+	 *   calling thread; returns after all chunks are done.
+	 *
+	 * @note The calling thread takes chunks as well, so that it doesn't wait
+	 *   for the workers which are busy with other tasks.
+	 */
+	static void fork(int count, int chunks, const Proc &proc);
+};
+
 /**
  * @brief Gets whether a shared pointer is unique.
  */
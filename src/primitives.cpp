@@ -8,13 +8,13 @@
 ** For the latest info, see https://github.com/paladin-t/bitty/
 */
 
-#include "datetime.h"
 #include "encoding.h"
 #include "primitives.h"
 #include "project.h"
 #include "renderer.h"
 #include "resource/inline_resource.h"
 #include "../lib/sdl_gfx/SDL2_gfxPrimitives.h"
+#include <condition_variable>
 
 /*
 ** {===========================================================================
@@ -25,6 +25,14 @@
 #	pragma message("Multithread disabled.")
 #endif /* BITTY_MULTITHREAD_ENABLED */
 
+#ifndef PRIMITIVES_FRAME_COUNT
+#	define PRIMITIVES_FRAME_COUNT 4
+#endif /* PRIMITIVES_FRAME_COUNT */
+#ifndef PRIMITIVES_FRAME_BLOCK_SIZE
+#	define PRIMITIVES_FRAME_BLOCK_SIZE (64 * 1024)
+#endif /* PRIMITIVES_FRAME_BLOCK_SIZE */
+static_assert(PRIMITIVES_FRAME_COUNT >= 3, "At least 3 frames are required.");
+
 /* ===========================================================================} */
 
 /*
@@ -46,16 +54,20 @@ public:
 		PIE,
 		RECT,
 		TRI,
+		GEOMETRY,
 		FONT,
 		TEXT,
 		TEX,
 		SPR,
+		TEXS,
+		SPRS,
 		PLAY_SPR,
 		MAP,
 		PGET,
 		PSET,
 		MGET,
 		MSET,
+		MSETS,
 		VOLUME,
 		PLAY_SFX,
 		PLAY_MUSIC,
@@ -75,6 +87,7 @@ public:
 public:
 	Types type = NONE;
 	Dtor dtor = [] (Cmd*) -> void { /* Do nothing. */ };
+	unsigned size = 0; // Record size in the frame arena.
 };
 
 class CmdClippable {
@@ -790,6 +803,141 @@ private:
 #endif /* SDL_VERSION_ATLEAST(2, 0, 18) */
 };
 
+class CmdGeometry : public Cmd, public CmdClippable {
+private:
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	typedef std::vector<SDL_Vertex> Vertices;
+#endif /* SDL_VERSION_ATLEAST(2, 0, 18) */
+
+private:
+	int _triangleCount = 0; // Count of the triangles that follow this command in the arena.
+	int _lineCount = 0; // Count of the line segments that follow the triangles.
+	int _offsetX = 0, _offsetY = 0;
+
+public:
+	CmdGeometry() {
+		type = GEOMETRY;
+		dtor = [] (Cmd* cmd) -> void {
+			CmdGeometry* self = reinterpret_cast<CmdGeometry*>(cmd);
+			self->~CmdGeometry();
+		};
+	}
+	CmdGeometry(const Primitives::Vertex* triangles, int triangleCount, const Primitives::Vertex* lines, int lineCount, int offsetX, int offsetY) {
+		type = GEOMETRY;
+		dtor = [] (Cmd* cmd) -> void {
+			CmdGeometry* self = reinterpret_cast<CmdGeometry*>(cmd);
+			self->~CmdGeometry();
+		};
+
+		_triangleCount = triangleCount;
+		_lineCount = lineCount;
+		_offsetX = offsetX;
+		_offsetY = offsetY;
+		Primitives::Vertex* verts = vertices();
+		if (triangleCount > 0)
+			std::uninitialized_copy(triangles, triangles + triangleCount * 3, verts);
+		if (lineCount > 0)
+			std::uninitialized_copy(lines, lines + lineCount * 2, verts + triangleCount * 3);
+	}
+
+	void run(Renderer* rnd) {
+		clip(rnd, true);
+
+		SDL_Renderer* renderer = (SDL_Renderer*)rnd->pointer();
+		const Primitives::Vertex* verts = vertices();
+		const Primitives::Vertex* lines = verts + _triangleCount * 3;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+		if (_triangleCount > 0 || _lineCount > 0) {
+			Vertices buf;
+			buf.reserve(_triangleCount * 3 + _lineCount * 6);
+			for (int i = 0; i < _triangleCount * 3; ++i) {
+				const Primitives::Vertex &v = verts[i];
+				buf.push_back(
+					SDL_Vertex{
+						SDL_FPoint{ v.x - _offsetX, v.y - _offsetY },
+						SDL_Color{ v.color.r, v.color.g, v.color.b, v.color.a },
+						SDL_FPoint{ 0, 0 }
+					}
+				);
+			}
+			for (int i = 0; i < _lineCount; ++i) {
+				const Primitives::Vertex &v0 = lines[i * 2 + 0];
+				const Primitives::Vertex &v1 = lines[i * 2 + 1];
+				segment(
+					buf,
+					v0.x - _offsetX, v0.y - _offsetY,
+					v1.x - _offsetX, v1.y - _offsetY,
+					v0.color
+				);
+			}
+
+			SDL_RenderGeometry(renderer, nullptr, &buf.front(), (int)buf.size(), nullptr, 0);
+		}
+#else /* SDL_VERSION_ATLEAST(2, 0, 18) */
+		for (int i = 0; i < _triangleCount; ++i) {
+			const Primitives::Vertex &v0 = verts[i * 3 + 0];
+			const Primitives::Vertex &v1 = verts[i * 3 + 1];
+			const Primitives::Vertex &v2 = verts[i * 3 + 2];
+			filledTrigonColor(
+				renderer,
+				(Sint16)(v0.x - _offsetX), (Sint16)(v0.y - _offsetY),
+				(Sint16)(v1.x - _offsetX), (Sint16)(v1.y - _offsetY),
+				(Sint16)(v2.x - _offsetX), (Sint16)(v2.y - _offsetY),
+				v0.color.toRGBA()
+			);
+		}
+		for (int i = 0; i < _lineCount; ++i) {
+			const Primitives::Vertex &v0 = lines[i * 2 + 0];
+			const Primitives::Vertex &v1 = lines[i * 2 + 1];
+			lineColor(
+				renderer,
+				(Sint16)(v0.x - _offsetX), (Sint16)(v0.y - _offsetY),
+				(Sint16)(v1.x - _offsetX), (Sint16)(v1.y - _offsetY),
+				v0.color.toRGBA()
+			);
+		}
+#endif /* SDL_VERSION_ATLEAST(2, 0, 18) */
+
+		clip(rnd, false);
+	}
+
+private:
+	Primitives::Vertex* vertices(void) {
+		return reinterpret_cast<Primitives::Vertex*>(this + 1);
+	}
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	/**
+	 * @brief Appends a line segment as a one pixel wide quad in two triangles;
+	 *   it runs through the pixel centers and covers both end pixels, like a
+	 *   rasterized line does.
+	 */
+	static void segment(Vertices &buf, float x0, float y0, float x1, float y1, const Color &col) {
+		float dx = x1 - x0;
+		float dy = y1 - y0;
+		const float len = std::sqrt(dx * dx + dy * dy);
+		if (len > 0) {
+			dx = dx / len * 0.5f;
+			dy = dy / len * 0.5f;
+		} else {
+			dx = 0.5f;
+			dy = 0;
+		}
+		x0 += 0.5f - dx; y0 += 0.5f - dy; // Extends half a pixel beyond each end.
+		x1 += 0.5f + dx; y1 += 0.5f + dy;
+
+		const SDL_Color c{ col.r, col.g, col.b, col.a };
+		const SDL_Vertex a{ SDL_FPoint{ x0 - dy, y0 + dx }, c, SDL_FPoint{ 0, 0 } };
+		const SDL_Vertex b{ SDL_FPoint{ x0 + dy, y0 - dx }, c, SDL_FPoint{ 0, 0 } };
+		const SDL_Vertex d{ SDL_FPoint{ x1 + dy, y1 - dx }, c, SDL_FPoint{ 0, 0 } };
+		const SDL_Vertex e{ SDL_FPoint{ x1 - dy, y1 + dx }, c, SDL_FPoint{ 0, 0 } };
+		buf.push_back(a); buf.push_back(b); buf.push_back(d);
+		buf.push_back(a); buf.push_back(d); buf.push_back(e);
+	}
+#endif /* SDL_VERSION_ATLEAST(2, 0, 18) */
+};
+
 class CmdFont : public Cmd {
 private:
 	Font::Ptr _font = nullptr;
@@ -820,9 +968,172 @@ public:
 	}
 };
 
+/**
+ * @brief Batch of textured quads, which are submitted to the renderer by a
+ *   single geometry call.
+ *
+ * @note Consecutive text, texture and sprite commands that share the same
+ *   texture and clipping area are merged into one batch, any other drawing
+ *   command flushes it first. Rotation, flipping and coloring are baked into the
+ *   vertices. Falls back to one copy per command without geometry support.
+ */
+class CmdBatch : public NonCopyable {
+private:
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	typedef std::vector<SDL_Vertex> Vertices;
+	typedef std::vector<int> Indices;
+#endif /* SDL_VERSION_ATLEAST(2, 0, 18) */
+
+private:
+	Texture::Ptr _texture = nullptr; // Holds the texture until flushed.
+	void* _pointer = nullptr;
+	bool _clipping = false;
+	Math::Recti _clip;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+	Vertices _vertices;
+	Indices _indices;
+#endif /* SDL_VERSION_ATLEAST(2, 0, 18) */
+
+public:
+	/**
+	 * @brief Adds a textured quad to the batch.
+	 *
+	 * @return `true` if the quad has been handled by the batch, otherwise it
+	 *   should be rendered by the caller.
+	 */
+	bool add(
+		Renderer* rnd,
+		Texture::Ptr tex,
+		const Math::Recti &srcRect, const Math::Recti &dstRect,
+		const double* rotAngle, const Math::Vec2f* rotCenter,
+		bool hFlip, bool vFlip,
+		const Color* color,
+		const Math::Recti* clipping
+	) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+		if (!tex)
+			return true;
+		void* ptr = tex->pointer(rnd);
+		if (!ptr)
+			return true;
+		const int texWidth = tex->width();
+		const int texHeight = tex->height();
+		if (texWidth <= 0 || texHeight <= 0)
+			return true;
+
+		if (ptr != _pointer || _clipping != !!clipping || (clipping && !(*clipping == _clip)))
+			flush(rnd);
+
+		if (!_texture) {
+			_texture = tex;
+			_pointer = ptr;
+			_clipping = !!clipping;
+			if (clipping)
+				_clip = *clipping;
+		}
+
+		// Calculate the texture coordinates.
+		float u0 = (float)srcRect.xMin() / texWidth;
+		float v0 = (float)srcRect.yMin() / texHeight;
+		float u1 = (float)(srcRect.xMin() + srcRect.width()) / texWidth;
+		float v1 = (float)(srcRect.yMin() + srcRect.height()) / texHeight;
+		if (hFlip)
+			std::swap(u0, u1);
+		if (vFlip)
+			std::swap(v0, v1);
+
+		// Calculate the corners, the same way as the renderer's copy.
+		const float x = (float)dstRect.xMin();
+		const float y = (float)dstRect.yMin();
+		const float w = (float)dstRect.width();
+		const float h = (float)dstRect.height();
+		Math::Vec2f corners[4] = {
+			Math::Vec2f(x, y),
+			Math::Vec2f(x + w, y),
+			Math::Vec2f(x + w, y + h),
+			Math::Vec2f(x, y + h)
+		};
+		if (rotAngle && *rotAngle != 0.0) {
+			Math::Vec2f ctr(w * 0.5f, h * 0.5f);
+			if (rotCenter)
+				ctr = Math::Vec2f((float)(int)(rotCenter->x * w), (float)(int)(rotCenter->y * h));
+			ctr += Math::Vec2f(x, y);
+			const double rad = Math::degToRad(*rotAngle);
+			const float s = (float)std::sin(rad);
+			const float c = (float)std::cos(rad);
+			for (Math::Vec2f &pt : corners) {
+				const float dx = pt.x - ctr.x;
+				const float dy = pt.y - ctr.y;
+				pt = Math::Vec2f(dx * c - dy * s + ctr.x, dx * s + dy * c + ctr.y);
+			}
+		}
+
+		// Fill in the vertices.
+		const SDL_Color col = color ?
+			SDL_Color{ color->r, color->g, color->b, color->a } :
+			SDL_Color{ 255, 255, 255, 255 };
+		const int base = (int)_vertices.size();
+		_vertices.push_back(SDL_Vertex{ SDL_FPoint{ (float)corners[0].x, (float)corners[0].y }, col, SDL_FPoint{ u0, v0 } });
+		_vertices.push_back(SDL_Vertex{ SDL_FPoint{ (float)corners[1].x, (float)corners[1].y }, col, SDL_FPoint{ u1, v0 } });
+		_vertices.push_back(SDL_Vertex{ SDL_FPoint{ (float)corners[2].x, (float)corners[2].y }, col, SDL_FPoint{ u1, v1 } });
+		_vertices.push_back(SDL_Vertex{ SDL_FPoint{ (float)corners[3].x, (float)corners[3].y }, col, SDL_FPoint{ u0, v1 } });
+		_indices.push_back(base + 0);
+		_indices.push_back(base + 1);
+		_indices.push_back(base + 2);
+		_indices.push_back(base + 0);
+		_indices.push_back(base + 2);
+		_indices.push_back(base + 3);
+
+		return true;
+#else /* SDL_VERSION_ATLEAST(2, 0, 18) */
+		(void)rnd;
+		(void)tex;
+		(void)srcRect;
+		(void)dstRect;
+		(void)rotAngle;
+		(void)rotCenter;
+		(void)hFlip;
+		(void)vFlip;
+		(void)color;
+		(void)clipping;
+
+		return false;
+#endif /* SDL_VERSION_ATLEAST(2, 0, 18) */
+	}
+	/**
+	 * @brief Submits the pending quads to the renderer.
+	 */
+	void flush(Renderer* rnd) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+		if (!_texture)
+			return;
+
+		if (!_indices.empty()) {
+			if (_clipping)
+				rnd->clip(_clip.xMin(), _clip.yMin(), _clip.width(), _clip.height());
+			SDL_RenderGeometry(
+				(SDL_Renderer*)rnd->pointer(), (SDL_Texture*)_pointer,
+				&_vertices.front(), (int)_vertices.size(),
+				&_indices.front(), (int)_indices.size()
+			);
+			if (_clipping)
+				rnd->clip();
+		}
+
+		_vertices.clear();
+		_indices.clear();
+		_texture = nullptr;
+		_pointer = nullptr;
+		_clipping = false;
+#else /* SDL_VERSION_ATLEAST(2, 0, 18) */
+		(void)rnd;
+#endif /* SDL_VERSION_ATLEAST(2, 0, 18) */
+	}
+};
+
 class CmdText : public Cmd, public CmdClippable, public CmdColored {
 private:
-	std::wstring _text;
+	int _length = 0; // Count of the codepoints that follow this command in the arena.
 	int _x = 0, _y = 0;
 	int _margin = 0;
 	bool _scaled = false;
@@ -843,7 +1154,7 @@ public:
 			self->~CmdText();
 		};
 
-		_text = Unicode::toWide(text);
+		_length = decode(text, codepoints());
 		_x = x;
 		_y = y;
 		_margin = margin;
@@ -853,54 +1164,113 @@ public:
 		}
 	}
 
-	void run(Renderer* rnd, Resources* res) {
-		clip(rnd, true);
+	void run(Renderer* rnd, Resources* res, CmdBatch* batch) {
+		if (!res)
+			return;
 
-		const wchar_t* text = _text.c_str();
-		int x = _x, y = _y;
-		while (*text) {
-			if (!res)
-				break;
+		Color col;
+		bool colorChanged = false, alphaChanged = false;
+		const bool colorful = colored(&col, &colorChanged, &alphaChanged);
 
-			const Resources::Id cp = *text++;
+		int cx = 0, cy = 0, cw = 0, ch = 0;
+		const bool clipping = clip(&cx, &cy, &cw, &ch);
+		const Math::Recti clipRect = Math::Recti::byXYWH(cx, cy, cw, ch);
 
-			const Color WHITE(255, 255, 255, 255);
-			int width = -1, height = -1;
-			Resources::Glyph glyph(cp, &WHITE);
-			Texture::Ptr ptr = res->load(rnd, glyph, &width, &height);
+		CmdBatch local; // Draws the string at once without a shared batch.
+		CmdBatch* glyphs = batch ? batch : &local;
+
+		const Resources::Id* text = codepoints();
+		int x = _x, y = _y;
+		for (int i = 0; i < _length; ++i) {
+			const Resources::Id cp = text[i];
+
+			Math::Recti srcRect;
+			Texture::Ptr ptr = res->glyph(rnd, cp, &srcRect);
 			if (!ptr)
 				continue;
 
-			Math::Recti dstRect(
-				x, y,
-				x + ptr->width() - 1, y + ptr->height() - 1
-			);
+			Math::Recti dstRect = Math::Recti::byXYWH(x, y, srcRect.width(), srcRect.height());
 			int margin = _margin;
 			if (_scaled) {
-				dstRect = Math::Recti(
+				dstRect = Math::Recti::byXYWH(
 					x, y,
-					x + (Int)(ptr->width() * _scale) - 1, y + (Int)(ptr->height() * _scale) - 1
+					(Int)(srcRect.width() * _scale), (Int)(srcRect.height() * _scale)
 				);
 				margin = (int)(margin * _scale);
 			}
 
-			Color col;
-			bool colorChanged = false, alphaChanged = false;
-			colored(&col, &colorChanged, &alphaChanged);
-
-			rnd->render(
-				ptr.get(),
-				nullptr, &dstRect,
+			const bool batched = glyphs->add(
+				rnd,
+				ptr,
+				srcRect, dstRect,
 				nullptr, nullptr,
 				false, false,
-				&col, colorChanged, alphaChanged
+				colorful ? &col : nullptr,
+				clipping ? &clipRect : nullptr
 			);
+			if (!batched) {
+				clip(rnd, true);
+				rnd->render(
+					ptr.get(),
+					&srcRect, &dstRect,
+					nullptr, nullptr,
+					false, false,
+					&col, colorChanged, alphaChanged
+				);
+				clip(rnd, false);
+			}
 			x += dstRect.width();
-			if (*text)
+			if (i + 1 < _length)
 				x += margin;
 		}
 
-		clip(rnd, false);
+		local.flush(rnd);
+	}
+
+	/**
+	 * @brief Decodes UTF-8 text to codepoints.
+	 *
+	 * @param[out] codepoints The buffer to receive codepoints, `nullptr` to count only.
+	 * @return The count of codepoints.
+	 */
+	static int decode(const char* text, Resources::Id* codepoints /* nullable */) {
+		int result = 0;
+		const unsigned char* ch = (const unsigned char*)text;
+		while (*ch) {
+			int n = 1;
+			Resources::Id cp = *ch;
+			if (cp >= 0xf0) {
+				n = 4;
+				cp &= 0x07;
+			} else if (cp >= 0xe0) {
+				n = 3;
+				cp &= 0x0f;
+			} else if (cp >= 0xc0) {
+				n = 2;
+				cp &= 0x1f;
+			} else if (cp >= 0x80) {
+				++ch; // Skip unexpected continuation byte.
+
+				continue;
+			}
+			int i = 1;
+			for (; i < n && (ch[i] & 0xc0) == 0x80; ++i)
+				cp = (cp << 6) | (ch[i] & 0x3f);
+			ch += i;
+			if (i < n)
+				continue; // Skip truncated sequence.
+
+			if (codepoints)
+				codepoints[result] = cp;
+			++result;
+		}
+
+		return result;
+	}
+
+private:
+	Resources::Id* codepoints(void) {
+		return reinterpret_cast<Resources::Id*>(this + 1);
 	}
 };
 
@@ -947,9 +1317,7 @@ public:
 		_vFlip = vFlip;
 	}
 
-	void run(Primitives* primitives, Renderer* rnd, const Project* project, Resources* res) {
-		clip(rnd, true);
-
+	void run(Primitives* primitives, Renderer* rnd, const Project* project, Resources* res, CmdBatch* batch) {
 		do {
 			if (!res)
 				break;
@@ -975,8 +1343,27 @@ public:
 
 			Color col;
 			bool colorChanged = false, alphaChanged = false;
-			colored(&col, &colorChanged, &alphaChanged);
+			const bool colorful = colored(&col, &colorChanged, &alphaChanged);
+
+			int x = 0, y = 0, w = 0, h = 0;
+			const bool clipping = clip(&x, &y, &w, &h);
+			const Math::Recti clipRect = Math::Recti::byXYWH(x, y, w, h);
+
+			if (batch) {
+				const bool batched = batch->add(
+					rnd,
+					ptr,
+					srcRect, dstRect,
+					_rotated ? &_rotAngle : nullptr, &_rotCenter,
+					_hFlip, _vFlip,
+					colorful ? &col : nullptr,
+					clipping ? &clipRect : nullptr
+				);
+				if (batched)
+					break;
+			}
 
+			clip(rnd, true);
 			rnd->render(
 				ptr.get(),
 				&srcRect, &dstRect,
@@ -984,9 +1371,8 @@ public:
 				_hFlip, _vFlip,
 				&col, colorChanged, alphaChanged
 			);
+			clip(rnd, false);
 		} while (false);
-
-		clip(rnd, false);
 	}
 };
 
@@ -1027,9 +1413,7 @@ public:
 		_delta = delta;
 	}
 
-	void run(Renderer* rnd, const Project* project, Resources* res, const double* delta, unsigned frameId) {
-		clip(rnd, true);
-
+	void run(Renderer* rnd, const Project* project, Resources* res, const double* delta, unsigned frameId, CmdBatch* batch) {
 		do {
 			if (!res)
 				break;
@@ -1049,17 +1433,244 @@ public:
 
 			Color col;
 			bool colorChanged = false, alphaChanged = false;
-			colored(&col, &colorChanged, &alphaChanged);
+			const bool colorful = colored(&col, &colorChanged, &alphaChanged);
+
+			int x = 0, y = 0, w = 0, h = 0;
+			const bool clipping = clip(&x, &y, &w, &h);
+			const Math::Recti clipRect = Math::Recti::byXYWH(x, y, w, h);
+
+			if (batch) {
+				Texture::Ptr tex = nullptr;
+				Math::Recti area;
+				if (!ptr->current(nullptr, &tex, &area, nullptr, nullptr) || !tex)
+					break;
+
+				const Math::Recti dstRect = Math::Recti::byXYWH(_x, _y, _width, _height);
+				const Math::Recti viewport = Math::Recti::byXYWH(0, 0, rnd->width(), rnd->height());
+				if (!Math::intersects(viewport, dstRect))
+					break;
+
+				const bool batched = batch->add(
+					rnd,
+					tex,
+					area, dstRect,
+					_rotated ? &_rotAngle : nullptr, &_rotCenter,
+					ptr->hFlip(), ptr->vFlip(),
+					colorful ? &col : nullptr,
+					clipping ? &clipRect : nullptr
+				);
+				if (batched)
+					break;
+			}
 
+			clip(rnd, true);
 			ptr->render(
 				rnd,
 				_x, _y, _width, _height,
 				_rotated ? &_rotAngle : nullptr, &_rotCenter,
 				&col, colorChanged, alphaChanged
 			);
+			clip(rnd, false);
 		} while (false);
+	}
+};
 
-		clip(rnd, false);
+class CmdTexs : public Cmd, public CmdClippable {
+private:
+	Resources::Texture::Ptr _texture = nullptr;
+	int _count = 0; // Count of the instances that follow this command in the arena.
+	int _offsetX = 0, _offsetY = 0;
+
+public:
+	CmdTexs() {
+		type = TEXS;
+		dtor = [] (Cmd* cmd) -> void {
+			CmdTexs* self = reinterpret_cast<CmdTexs*>(cmd);
+			self->~CmdTexs();
+		};
+	}
+	CmdTexs(Resources::Texture::Ptr tex, int count, const Primitives::InstanceFiller &fill, int offsetX, int offsetY) {
+		type = TEXS;
+		dtor = [] (Cmd* cmd) -> void {
+			CmdTexs* self = reinterpret_cast<CmdTexs*>(cmd);
+			self->~CmdTexs();
+		};
+
+		_texture = tex;
+		_count = count;
+		_offsetX = offsetX;
+		_offsetY = offsetY;
+		std::uninitialized_fill_n(instances(), count, Primitives::Instance());
+		fill(instances(), count);
+	}
+
+	void run(Primitives* primitives, Renderer* rnd, const Project* project, Resources* res, CmdBatch* batch) {
+		if (!res)
+			return;
+
+		Texture::Ptr ptr = nullptr;
+		if (_texture)
+			ptr = res->load(project, *_texture);
+		else
+			ptr = primitives->canvas();
+		if (!ptr)
+			return;
+
+		int cx = 0, cy = 0, cw = 0, ch = 0;
+		const bool clipping = clip(&cx, &cy, &cw, &ch);
+		const Math::Recti clipRect = Math::Recti::byXYWH(cx, cy, cw, ch);
+		const Math::Recti viewport = Math::Recti::byXYWH(0, 0, rnd->width(), rnd->height());
+		const Math::Vec2f rotCenter(0.5f, 0.5f);
+		const Color WHITE(255, 255, 255, 255);
+
+		CmdBatch local; // Draws the instances at once without a shared batch.
+		CmdBatch* quads = batch ? batch : &local;
+
+		const Primitives::Instance* insts = instances();
+		for (int i = 0; i < _count; ++i) {
+			const Primitives::Instance &inst = insts[i];
+
+			const Math::Recti dstRect = Math::Recti::byXYWH(
+				inst.x - _offsetX, inst.y - _offsetY,
+				inst.width > 0 ? inst.width : ptr->width(), inst.height > 0 ? inst.height : ptr->height()
+			);
+			if (inst.rotAngle == 0 && !Math::intersects(viewport, dstRect))
+				continue;
+			const Math::Recti srcRect = Math::Recti::byXYWH(
+				inst.sx, inst.sy,
+				inst.swidth > 0 ? inst.swidth : ptr->width(), inst.sheight > 0 ? inst.sheight : ptr->height()
+			);
+			const double rotAngle = inst.rotAngle;
+
+			const bool batched = quads->add(
+				rnd,
+				ptr,
+				srcRect, dstRect,
+				rotAngle != 0 ? &rotAngle : nullptr, &rotCenter,
+				false, false,
+				inst.color != WHITE ? &inst.color : nullptr,
+				clipping ? &clipRect : nullptr
+			);
+			if (!batched) {
+				clip(rnd, true);
+				rnd->render(
+					ptr.get(),
+					&srcRect, &dstRect,
+					rotAngle != 0 ? &rotAngle : nullptr, &rotCenter,
+					false, false,
+					&inst.color, inst.color.r != 255 || inst.color.g != 255 || inst.color.b != 255, inst.color.a != 255
+				);
+				clip(rnd, false);
+			}
+		}
+
+		local.flush(rnd);
+	}
+
+private:
+	Primitives::Instance* instances(void) {
+		return reinterpret_cast<Primitives::Instance*>(this + 1);
+	}
+};
+
+class CmdSprs : public Cmd, public CmdClippable {
+private:
+	Resources::Sprite::Ptr _sprite = nullptr;
+	int _count = 0; // Count of the instances that follow this command in the arena.
+	int _offsetX = 0, _offsetY = 0;
+	double _delta = 0.0;
+
+public:
+	CmdSprs() {
+		type = SPRS;
+		dtor = [] (Cmd* cmd) -> void {
+			CmdSprs* self = reinterpret_cast<CmdSprs*>(cmd);
+			self->~CmdSprs();
+		};
+	}
+	CmdSprs(Resources::Sprite::Ptr spr, int count, const Primitives::InstanceFiller &fill, int offsetX, int offsetY, double delta) {
+		type = SPRS;
+		dtor = [] (Cmd* cmd) -> void {
+			CmdSprs* self = reinterpret_cast<CmdSprs*>(cmd);
+			self->~CmdSprs();
+		};
+
+		_sprite = spr;
+		_count = count;
+		_offsetX = offsetX;
+		_offsetY = offsetY;
+		_delta = delta;
+		std::uninitialized_fill_n(instances(), count, Primitives::Instance());
+		fill(instances(), count);
+	}
+
+	void run(Renderer* rnd, const Project* project, Resources* res, const double* delta, unsigned frameId, CmdBatch* batch) {
+		if (!res)
+			return;
+
+		Sprite::Ptr ptr = res->load(project, *_sprite);
+		if (!ptr)
+			return;
+
+		LockGuard<RecursiveMutex> guard(_sprite->lock);
+
+		ptr->update(delta ? *delta : _delta, &frameId);
+
+		Texture::Ptr tex = nullptr;
+		Math::Recti srcRect;
+		if (!ptr->current(nullptr, &tex, &srcRect, nullptr, nullptr) || !tex)
+			return;
+
+		int cx = 0, cy = 0, cw = 0, ch = 0;
+		const bool clipping = clip(&cx, &cy, &cw, &ch);
+		const Math::Recti clipRect = Math::Recti::byXYWH(cx, cy, cw, ch);
+		const Math::Recti viewport = Math::Recti::byXYWH(0, 0, rnd->width(), rnd->height());
+		const Math::Vec2f rotCenter(0.5f, 0.5f);
+		const Color WHITE(255, 255, 255, 255);
+
+		CmdBatch local; // Draws the instances at once without a shared batch.
+		CmdBatch* quads = batch ? batch : &local;
+
+		const Primitives::Instance* insts = instances();
+		for (int i = 0; i < _count; ++i) {
+			const Primitives::Instance &inst = insts[i];
+
+			const Math::Recti dstRect = Math::Recti::byXYWH(
+				inst.x - _offsetX, inst.y - _offsetY,
+				inst.width > 0 ? inst.width : ptr->width(), inst.height > 0 ? inst.height : ptr->height()
+			);
+			if (!Math::intersects(viewport, dstRect))
+				continue;
+			const double rotAngle = inst.rotAngle;
+
+			const bool batched = quads->add(
+				rnd,
+				tex,
+				srcRect, dstRect,
+				rotAngle != 0 ? &rotAngle : nullptr, &rotCenter,
+				ptr->hFlip(), ptr->vFlip(),
+				inst.color != WHITE ? &inst.color : nullptr,
+				clipping ? &clipRect : nullptr
+			);
+			if (!batched) {
+				clip(rnd, true);
+				rnd->render(
+					tex.get(),
+					&srcRect, &dstRect,
+					rotAngle != 0 ? &rotAngle : nullptr, &rotCenter,
+					ptr->hFlip(), ptr->vFlip(),
+					&inst.color, inst.color.r != 255 || inst.color.g != 255 || inst.color.b != 255, inst.color.a != 255
+				);
+				clip(rnd, false);
+			}
+		}
+
+		local.flush(rnd);
+	}
+
+private:
+	Primitives::Instance* instances(void) {
+		return reinterpret_cast<Primitives::Instance*>(this + 1);
 	}
 };
 
@@ -1209,19 +1820,34 @@ public:
 	void wait(Color &col) {
 		col = Color();
 
-		if (!_palette)
-			return;
+		const Palette::Ptr &shadow = snapshot(_palette);
+		if (shadow)
+			shadow->get(_index, col);
+	}
 
-		if (_palette->shadow)
-			_palette->shadow->get(_index, col);
+	/**
+	 * @brief Gets the shadow copy of the palette which is owned by the
+	 *   executing thread, clones it on the first access; readings on it don't
+	 *   need to lock.
+	 */
+	static const Palette::Ptr &snapshot(const Resources::Palette::Ptr &palette) {
+		static const Palette::Ptr NIL = nullptr;
 
-		const Palette::Ptr &plt = _palette->pointer;
-		if (!plt)
-			return;
+		if (!palette)
+			return NIL;
 
-		LockGuard<Mutex> guard(_palette->lock);
+		if (palette->shadow)
+			return palette->shadow;
+
+		const Palette::Ptr &plt = palette->pointer;
+		Palette* ptr = nullptr;
+
+		LockGuard<Mutex> guard(palette->lock);
+
+		if (plt && plt->clone(&ptr, false) && ptr)
+			palette->shadow = Palette::Ptr(ptr);
 
-		plt->get(_index, col);
+		return palette->shadow;
 	}
 };
 
@@ -1314,22 +1940,34 @@ public:
 	void wait(int &cel) {
 		cel = Map::INVALID();
 
-		if (!_map)
-			return;
+		const Map::Ptr &shadow = snapshot(_map);
+		if (shadow)
+			cel = shadow->get(_x, _y);
+	}
 
-		if (_map->shadow) {
-			cel = _map->shadow->get(_x, _y);
-
-			return;
-		}
+	/**
+	 * @brief Gets the shadow copy of the map which is owned by the executing
+	 *   thread, clones it on the first access; readings on it don't need to
+	 *   lock.
+	 */
+	static const Map::Ptr &snapshot(const Resources::Map::Ptr &map) {
+		static const Map::Ptr NIL = nullptr;
 
-		const Map::Ptr &map = _map->pointer;
 		if (!map)
-			return;
+			return NIL;
 
-		LockGuard<Mutex> guard(_map->lock);
+		if (map->shadow)
+			return map->shadow;
+
+		const Map::Ptr &obj = map->pointer;
+		Map* ptr = nullptr;
 
-		cel = map->get(_x, _y);
+		LockGuard<Mutex> guard(map->lock);
+
+		if (obj && obj->clone(&ptr, false) && ptr)
+			map->shadow = Map::Ptr(ptr);
+
+		return map->shadow;
 	}
 };
 
@@ -1394,6 +2032,140 @@ public:
 	}
 };
 
+class CmdMSets : public Cmd {
+public:
+	enum Modes {
+		FILL,
+		COPY,
+		EDIT
+	};
+
+private:
+	Resources::Map::Ptr _map = nullptr;
+	Modes _mode = FILL;
+	int _x = 0, _y = 0, _width = 0, _height = 0;
+	int _cel = Map::INVALID();
+	int _count = 0; // Count of the integers that follow this command in the arena.
+
+public:
+	CmdMSets() {
+		type = MSETS;
+		dtor = [] (Cmd* cmd) -> void {
+			CmdMSets* self = reinterpret_cast<CmdMSets*>(cmd);
+			self->~CmdMSets();
+		};
+	}
+	CmdMSets(Resources::Map::Ptr map, int x, int y, int width, int height, int cel) {
+		type = MSETS;
+		dtor = [] (Cmd* cmd) -> void {
+			CmdMSets* self = reinterpret_cast<CmdMSets*>(cmd);
+			self->~CmdMSets();
+		};
+
+		_map = map;
+		_mode = FILL;
+		_x = x;
+		_y = y;
+		_width = width;
+		_height = height;
+		_cel = cel;
+	}
+	CmdMSets(Resources::Map::Ptr map, int x, int y, int width, int height, const int* cels, int pitch) {
+		type = MSETS;
+		dtor = [] (Cmd* cmd) -> void {
+			CmdMSets* self = reinterpret_cast<CmdMSets*>(cmd);
+			self->~CmdMSets();
+		};
+
+		_map = map;
+		_mode = COPY;
+		_x = x;
+		_y = y;
+		_width = width;
+		_height = height;
+		_count = width * height; // Bounded by the map size.
+		for (int j = 0; j < height; ++j)
+			memcpy(data() + (size_t)j * width, cels + (size_t)j * pitch, sizeof(int) * width);
+	}
+	CmdMSets(Resources::Map::Ptr map, const int* edits, int count) {
+		type = MSETS;
+		dtor = [] (Cmd* cmd) -> void {
+			CmdMSets* self = reinterpret_cast<CmdMSets*>(cmd);
+			self->~CmdMSets();
+		};
+
+		_map = map;
+		_mode = EDIT;
+		_count = count * 3;
+		memcpy(data(), edits, sizeof(int) * _count);
+	}
+
+	void wait(void) {
+		if (!_map)
+			return;
+
+		Map::Ptr shadow = _map->shadow;
+		if (!shadow) {
+			const Map::Ptr &map = _map->pointer;
+			Map* ptr = nullptr;
+
+			LockGuard<Mutex> guard(_map->lock);
+
+			if (map && map->clone(&ptr, false) && ptr)
+				shadow = _map->shadow = Map::Ptr(ptr);
+		}
+
+		if (shadow)
+			apply(shadow.get());
+	}
+
+	void run(void) {
+		if (!_map)
+			return;
+
+		Map::Ptr map = _map->pointer;
+		if (!map)
+			return;
+
+		LockGuard<Mutex> guard(_map->lock);
+
+		apply(map.get());
+	}
+
+private:
+	int* data(void) {
+		return reinterpret_cast<int*>(this + 1);
+	}
+
+	void apply(Map* map) {
+		switch (_mode) {
+		case FILL:
+			for (int j = 0; j < _height; ++j) {
+				for (int i = 0; i < _width; ++i)
+					map->set(_x + i, _y + j, _cel, false);
+			}
+
+			break;
+		case COPY: {
+				const int* cels = data();
+				for (int j = 0; j < _height; ++j) {
+					for (int i = 0; i < _width; ++i)
+						map->set(_x + i, _y + j, cels[i + j * _width], false);
+				}
+			}
+
+			break;
+		case EDIT: {
+				const int* edits = data();
+				for (int k = 0; k + 2 < _count; k += 3)
+					map->set(edits[k], edits[k + 1], edits[k + 2], false);
+			}
+
+			break;
+		}
+	}
+};
+
 class CmdVolume : public Cmd {
 private:
 	int _sfxVolumeCount = 1;
@@ -1910,513 +2682,192 @@ public:
 	}
 };
 
-union CmdVariant {
-public:
-	Cmd cmd;
-	CmdTarget target;
-	CmdCls cls;
-	CmdBlend blend;
-	CmdPlot plot;
-	CmdLine line;
-	CmdCirc circ;
-	CmdEllipse ellipse;
-	CmdPie pie;
-	CmdRect rect;
-	CmdTri tri;
-	CmdFont font;
-	CmdText text;
-	CmdTex tex;
-	CmdSpr spr;
-	CmdPlaySpr playSpr;
-	CmdMap map;
-	CmdPGet pget;
-	CmdPSet pset;
-	CmdMGet mget;
-	CmdMSet mset;
-	CmdVolume volume;
-	CmdPlaySfx playSfx;
-	CmdPlayMusic playMusic;
-	CmdPauseSfx pauseSfx;
-	CmdPauseMusic pauseMusic;
-	CmdResumeSfx resumeSfx;
-	CmdResumeMusic resumeMusic;
-	CmdStopSfx stopSfx;
-	CmdStopMusic stopMusic;
-	CmdRumble rumble;
-	CmdCursor cursor;
-	CmdFunction function;
-
+/**
+ * @brief Dispatches commands by their type.
+ */
+struct CmdVariant {
 public:
-	CmdVariant() {
-		memset(this, 0, sizeof(CmdVariant));
-		new (&cmd) Cmd();
-	}
-	CmdVariant(const CmdVariant &other) {
-		memset(this, 0, sizeof(CmdVariant));
-		new (&cmd) Cmd();
-
-		switch (other.cmd.type) {
-		case Cmd::TARGET:
-			new (&target) CmdTarget();
-			target = other.target;
-
-			break;
-		case Cmd::CLS:
-			new (&cls) CmdCls();
-			cls = other.cls;
-
-			break;
-		case Cmd::BLEND:
-			new (&blend) CmdBlend();
-			blend = other.blend;
-
-			break;
-		case Cmd::PLOT:
-			new (&plot) CmdPlot();
-			plot = other.plot;
-
-			break;
-		case Cmd::LINE:
-			new (&line) CmdLine();
-			line = other.line;
-
-			break;
-		case Cmd::CIRC:
-			new (&circ) CmdCirc();
-			circ = other.circ;
-
-			break;
-		case Cmd::ELLIPSE:
-			new (&ellipse) CmdEllipse();
-			ellipse = other.ellipse;
-
-			break;
-		case Cmd::PIE:
-			new (&pie) CmdPie();
-			pie = other.pie;
-
-			break;
-		case Cmd::RECT:
-			new (&rect) CmdRect();
-			rect = other.rect;
-
-			break;
-		case Cmd::TRI:
-			new (&tri) CmdTri();
-			tri = other.tri;
-
-			break;
-		case Cmd::FONT:
-			new (&font) CmdFont();
-			font = other.font;
-
-			break;
-		case Cmd::TEXT:
-			new (&text) CmdText();
-			text = other.text;
-
-			break;
-		case Cmd::TEX:
-			new (&tex) CmdTex();
-			tex = other.tex;
-
-			break;
-		case Cmd::SPR:
-			new (&spr) CmdSpr();
-			spr = other.spr;
-
-			break;
-		case Cmd::PLAY_SPR:
-			new (&playSpr) CmdPlaySpr();
-			playSpr = other.playSpr;
-
-			break;
-		case Cmd::MAP:
-			new (&map) CmdMap();
-			map = other.map;
-
-			break;
-		case Cmd::PGET:
-			new (&pget) CmdPGet();
-			pget = other.pget;
-
-			break;
-		case Cmd::PSET:
-			new (&pset) CmdPSet();
-			pset = other.pset;
-
-			break;
-		case Cmd::MGET:
-			new (&mget) CmdMGet();
-			mget = other.mget;
-
-			break;
-		case Cmd::MSET:
-			new (&mset) CmdMSet();
-			mset = other.mset;
-
-			break;
+	static void transfer(Cmd* cmd) {
+		switch (cmd->type) {
 		case Cmd::VOLUME:
-			new (&volume) CmdVolume();
-			volume = other.volume;
+			static_cast<CmdVolume*>(cmd)->transfer();
 
 			break;
 		case Cmd::PLAY_SFX:
-			new (&playSfx) CmdPlaySfx();
-			playSfx = other.playSfx;
+			static_cast<CmdPlaySfx*>(cmd)->transfer();
 
 			break;
 		case Cmd::PLAY_MUSIC:
-			new (&playMusic) CmdPlayMusic();
-			playMusic = other.playMusic;
+			static_cast<CmdPlayMusic*>(cmd)->transfer();
 
 			break;
 		case Cmd::PAUSE_SFX:
-			new (&pauseSfx) CmdPauseSfx();
-			pauseSfx = other.pauseSfx;
+			static_cast<CmdPauseSfx*>(cmd)->transfer();
 
 			break;
 		case Cmd::PAUSE_MUSIC:
-			new (&pauseMusic) CmdPauseMusic();
-			pauseMusic = other.pauseMusic;
+			static_cast<CmdPauseMusic*>(cmd)->transfer();
 
 			break;
 		case Cmd::RESUME_SFX:
-			new (&resumeSfx) CmdResumeSfx();
-			resumeSfx = other.resumeSfx;
+			static_cast<CmdResumeSfx*>(cmd)->transfer();
 
 			break;
 		case Cmd::RESUME_MUSIC:
-			new (&resumeMusic) CmdResumeMusic();
-			resumeMusic = other.resumeMusic;
+			static_cast<CmdResumeMusic*>(cmd)->transfer();
 
 			break;
 		case Cmd::STOP_SFX:
-			new (&stopSfx) CmdStopSfx();
-			stopSfx = other.stopSfx;
+			static_cast<CmdStopSfx*>(cmd)->transfer();
 
 			break;
 		case Cmd::STOP_MUSIC:
-			new (&stopMusic) CmdStopMusic();
-			stopMusic = other.stopMusic;
+			static_cast<CmdStopMusic*>(cmd)->transfer();
 
 			break;
 		case Cmd::RUMBLE:
-			new (&rumble) CmdRumble();
-			rumble = other.rumble;
-
-			break;
-		case Cmd::CURSOR:
-			new (&cursor) CmdCursor();
-			cursor = other.cursor;
-
-			break;
-		case Cmd::FUNCTION:
-			new (&function) CmdFunction();
-			function = other.function;
+			static_cast<CmdRumble*>(cmd)->transfer();
 
 			break;
 		default:
-			assert(false && "Not implemented.");
+			// Do nothing.
 
 			break;
 		}
 	}
-	~CmdVariant() {
-		cmd.dtor(&cmd);
-
-		memset(this, 0, sizeof(CmdVariant));
-		new (&cmd) Cmd();
-	}
-
-	CmdVariant &operator = (const CmdVariant &other) {
-		cmd.dtor(&cmd);
-
-		memset(this, 0, sizeof(CmdVariant));
-		new (&cmd) Cmd();
-
-		switch (other.cmd.type) {
-		case Cmd::TARGET:
-			new (&target) CmdTarget();
-			target = other.target;
-
-			break;
-		case Cmd::CLS:
-			new (&cls) CmdCls();
-			cls = other.cls;
-
-			break;
-		case Cmd::BLEND:
-			new (&blend) CmdBlend();
-			blend = other.blend;
-
-			break;
-		case Cmd::PLOT:
-			new (&plot) CmdPlot();
-			plot = other.plot;
-
-			break;
-		case Cmd::LINE:
-			new (&line) CmdLine();
-			line = other.line;
-
-			break;
-		case Cmd::CIRC:
-			new (&circ) CmdCirc();
-			circ = other.circ;
-
-			break;
-		case Cmd::ELLIPSE:
-			new (&ellipse) CmdEllipse();
-			ellipse = other.ellipse;
-
-			break;
-		case Cmd::PIE:
-			new (&pie) CmdPie();
-			pie = other.pie;
-
-			break;
-		case Cmd::RECT:
-			new (&rect) CmdRect();
-			rect = other.rect;
-
-			break;
-		case Cmd::TRI:
-			new (&tri) CmdTri();
-			tri = other.tri;
-
-			break;
-		case Cmd::FONT:
-			new (&font) CmdFont();
-			font = other.font;
-
-			break;
-		case Cmd::TEXT:
-			new (&text) CmdText();
-			text = other.text;
-
-			break;
-		case Cmd::TEX:
-			new (&tex) CmdTex();
-			tex = other.tex;
-
-			break;
-		case Cmd::SPR:
-			new (&spr) CmdSpr();
-			spr = other.spr;
-
-			break;
-		case Cmd::PLAY_SPR:
-			new (&playSpr) CmdPlaySpr();
-			playSpr = other.playSpr;
-
-			break;
-		case Cmd::MAP:
-			new (&map) CmdMap();
-			map = other.map;
-
-			break;
-		case Cmd::PGET:
-			new (&pget) CmdPGet();
-			pget = other.pget;
-
-			break;
+	/**
+	 * @brief Applies the resource editing of the specific command, for frames
+	 *   that are discarded without being run.
+	 */
+	static void apply(Cmd* cmd) {
+		switch (cmd->type) {
 		case Cmd::PSET:
-			new (&pset) CmdPSet();
-			pset = other.pset;
-
-			break;
-		case Cmd::MGET:
-			new (&mget) CmdMGet();
-			mget = other.mget;
+			static_cast<CmdPSet*>(cmd)->run();
 
 			break;
 		case Cmd::MSET:
-			new (&mset) CmdMSet();
-			mset = other.mset;
+			static_cast<CmdMSet*>(cmd)->run();
 
 			break;
-		case Cmd::VOLUME:
-			new (&volume) CmdVolume();
-			volume = other.volume;
-
-			break;
-		case Cmd::PLAY_SFX:
-			new (&playSfx) CmdPlaySfx();
-			playSfx = other.playSfx;
-
-			break;
-		case Cmd::PLAY_MUSIC:
-			new (&playMusic) CmdPlayMusic();
-			playMusic = other.playMusic;
-
-			break;
-		case Cmd::PAUSE_SFX:
-			new (&pauseSfx) CmdPauseSfx();
-			pauseSfx = other.pauseSfx;
-
-			break;
-		case Cmd::PAUSE_MUSIC:
-			new (&pauseMusic) CmdPauseMusic();
-			pauseMusic = other.pauseMusic;
-
-			break;
-		case Cmd::RESUME_SFX:
-			new (&resumeSfx) CmdResumeSfx();
-			resumeSfx = other.resumeSfx;
-
-			break;
-		case Cmd::RESUME_MUSIC:
-			new (&resumeMusic) CmdResumeMusic();
-			resumeMusic = other.resumeMusic;
-
-			break;
-		case Cmd::STOP_SFX:
-			new (&stopSfx) CmdStopSfx();
-			stopSfx = other.stopSfx;
-
-			break;
-		case Cmd::STOP_MUSIC:
-			new (&stopMusic) CmdStopMusic();
-			stopMusic = other.stopMusic;
-
-			break;
-		case Cmd::RUMBLE:
-			new (&rumble) CmdRumble();
-			rumble = other.rumble;
-
-			break;
-		case Cmd::CURSOR:
-			new (&cursor) CmdCursor();
-			cursor = other.cursor;
-
-			break;
-		case Cmd::FUNCTION:
-			new (&function) CmdFunction();
-			function = other.function;
+		case Cmd::MSETS:
+			static_cast<CmdMSets*>(cmd)->run();
 
 			break;
 		default:
-			assert(false && "Not implemented.");
+			// Do nothing.
 
 			break;
 		}
-
-		return *this;
 	}
-
-	void transfer(void) {
-		switch (cmd.type) {
-		case Cmd::VOLUME:
-			volume.transfer();
-
-			break;
-		case Cmd::PLAY_SFX:
-			playSfx.transfer();
-
-			break;
-		case Cmd::PLAY_MUSIC:
-			playMusic.transfer();
-
-			break;
-		case Cmd::PAUSE_SFX:
-			pauseSfx.transfer();
-
-			break;
-		case Cmd::PAUSE_MUSIC:
-			pauseMusic.transfer();
-
-			break;
-		case Cmd::RESUME_SFX:
-			resumeSfx.transfer();
-
-			break;
-		case Cmd::RESUME_MUSIC:
-			resumeMusic.transfer();
-
-			break;
-		case Cmd::STOP_SFX:
-			stopSfx.transfer();
-
-			break;
-		case Cmd::STOP_MUSIC:
-			stopMusic.transfer();
-
-			break;
+	/**
+	 * @brief Gets whether the specific command can be merged into a batch, or
+	 *   doesn't touch the render target.
+	 */
+	static bool batchable(const Cmd* cmd) {
+		switch (cmd->type) {
+		case Cmd::FONT: // Fall through.
+		case Cmd::TEXT: // Fall through.
+		case Cmd::TEX: // Fall through.
+		case Cmd::SPR: // Fall through.
+		case Cmd::TEXS: // Fall through.
+		case Cmd::SPRS: // Fall through.
+		case Cmd::PLAY_SPR: // Fall through.
+		case Cmd::MSET: // Fall through.
+		case Cmd::MSETS: // Fall through.
+		case Cmd::VOLUME: // Fall through.
+		case Cmd::PLAY_SFX: // Fall through.
+		case Cmd::PLAY_MUSIC: // Fall through.
+		case Cmd::PAUSE_SFX: // Fall through.
+		case Cmd::PAUSE_MUSIC: // Fall through.
+		case Cmd::RESUME_SFX: // Fall through.
+		case Cmd::RESUME_MUSIC: // Fall through.
+		case Cmd::STOP_SFX: // Fall through.
+		case Cmd::STOP_MUSIC: // Fall through.
 		case Cmd::RUMBLE:
-			rumble.transfer();
-
-			break;
+			return true;
 		default:
-			// Do nothing.
-
-			break;
+			return false;
 		}
 	}
-	void run(Primitives* primitives, Renderer* rnd, const Project* project, Resources* res, Audio* audio, const double* delta, unsigned frameId) {
-		switch (cmd.type) {
+	static void run(Cmd* cmd, Primitives* primitives, Renderer* rnd, const Project* project, Resources* res, Audio* audio, const double* delta, unsigned frameId, CmdBatch* batch /* nullable */) {
+		if (batch && !batchable(cmd))
+			batch->flush(rnd);
+
+		switch (cmd->type) {
 		case Cmd::TARGET:
-			target.run(primitives, rnd, project, res);
+			static_cast<CmdTarget*>(cmd)->run(primitives, rnd, project, res);
 
 			break;
 		case Cmd::CLS:
-			cls.run(rnd);
+			static_cast<CmdCls*>(cmd)->run(rnd);
 
 			break;
 		case Cmd::BLEND:
-			blend.run(rnd, project, res);
+			static_cast<CmdBlend*>(cmd)->run(rnd, project, res);
 
 			break;
 		case Cmd::PLOT:
-			plot.run(rnd);
+			static_cast<CmdPlot*>(cmd)->run(rnd);
 
 			break;
 		case Cmd::LINE:
-			line.run(rnd);
+			static_cast<CmdLine*>(cmd)->run(rnd);
 
 			break;
 		case Cmd::CIRC:
-			circ.run(rnd);
+			static_cast<CmdCirc*>(cmd)->run(rnd);
 
 			break;
 		case Cmd::ELLIPSE:
-			ellipse.run(rnd);
+			static_cast<CmdEllipse*>(cmd)->run(rnd);
 
 			break;
 		case Cmd::PIE:
-			pie.run(rnd);
+			static_cast<CmdPie*>(cmd)->run(rnd);
 
 			break;
 		case Cmd::RECT:
-			rect.run(rnd);
+			static_cast<CmdRect*>(cmd)->run(rnd);
 
 			break;
 		case Cmd::TRI:
-			tri.run(rnd, project, res);
+			static_cast<CmdTri*>(cmd)->run(rnd, project, res);
+
+			break;
+		case Cmd::GEOMETRY:
+			static_cast<CmdGeometry*>(cmd)->run(rnd);
 
 			break;
 		case Cmd::FONT:
-			font.run(rnd, res);
+			static_cast<CmdFont*>(cmd)->run(rnd, res);
 
 			break;
 		case Cmd::TEXT:
-			text.run(rnd, res);
+			static_cast<CmdText*>(cmd)->run(rnd, res, batch);
 
 			break;
 		case Cmd::TEX:
-			tex.run(primitives, rnd, project, res);
+			static_cast<CmdTex*>(cmd)->run(primitives, rnd, project, res, batch);
 
 			break;
 		case Cmd::SPR:
-			spr.run(rnd, project, res, delta, frameId);
+			static_cast<CmdSpr*>(cmd)->run(rnd, project, res, delta, frameId, batch);
+
+			break;
+		case Cmd::TEXS:
+			static_cast<CmdTexs*>(cmd)->run(primitives, rnd, project, res, batch);
+
+			break;
+		case Cmd::SPRS:
+			static_cast<CmdSprs*>(cmd)->run(rnd, project, res, delta, frameId, batch);
 
 			break;
 		case Cmd::PLAY_SPR:
-			playSpr.run(project, res);
+			static_cast<CmdPlaySpr*>(cmd)->run(project, res);
 
 			break;
 		case Cmd::MAP:
-			map.run(rnd, project, res, delta, frameId);
+			static_cast<CmdMap*>(cmd)->run(rnd, project, res, delta, frameId);
 
 			break;
 		case Cmd::PGET:
@@ -2424,7 +2875,7 @@ public:
 
 			break;
 		case Cmd::PSET:
-			pset.run();
+			static_cast<CmdPSet*>(cmd)->run();
 
 			break;
 		case Cmd::MGET:
@@ -2432,55 +2883,59 @@ public:
 
 			break;
 		case Cmd::MSET:
-			mset.run();
+			static_cast<CmdMSet*>(cmd)->run();
+
+			break;
+		case Cmd::MSETS:
+			static_cast<CmdMSets*>(cmd)->run();
 
 			break;
 		case Cmd::VOLUME:
-			volume.run(audio);
+			static_cast<CmdVolume*>(cmd)->run(audio);
 
 			break;
 		case Cmd::PLAY_SFX:
-			playSfx.run(project, res);
+			static_cast<CmdPlaySfx*>(cmd)->run(project, res);
 
 			break;
 		case Cmd::PLAY_MUSIC:
-			playMusic.run(project, res);
+			static_cast<CmdPlayMusic*>(cmd)->run(project, res);
 
 			break;
 		case Cmd::PAUSE_SFX:
-			pauseSfx.run(project, res);
+			static_cast<CmdPauseSfx*>(cmd)->run(project, res);
 
 			break;
 		case Cmd::PAUSE_MUSIC:
-			pauseMusic.run(project, res);
+			static_cast<CmdPauseMusic*>(cmd)->run(project, res);
 
 			break;
 		case Cmd::RESUME_SFX:
-			resumeSfx.run(project, res);
+			static_cast<CmdResumeSfx*>(cmd)->run(project, res);
 
 			break;
 		case Cmd::RESUME_MUSIC:
-			resumeMusic.run(project, res);
+			static_cast<CmdResumeMusic*>(cmd)->run(project, res);
 
 			break;
 		case Cmd::STOP_SFX:
-			stopSfx.run(project, res);
+			static_cast<CmdStopSfx*>(cmd)->run(project, res);
 
 			break;
 		case Cmd::STOP_MUSIC:
-			stopMusic.run(project, res);
+			static_cast<CmdStopMusic*>(cmd)->run(project, res);
 
 			break;
 		case Cmd::RUMBLE:
-			rumble.run(primitives);
+			static_cast<CmdRumble*>(cmd)->run(primitives);
 
 			break;
 		case Cmd::CURSOR:
-			cursor.run(primitives);
+			static_cast<CmdCursor*>(cmd)->run(primitives);
 
 			break;
 		case Cmd::FUNCTION:
-			function.run(primitives);
+			static_cast<CmdFunction*>(cmd)->run(primitives);
 
 			break;
 		default:
@@ -2500,164 +2955,239 @@ public:
 
 /**
  * @brief Queue for primitive commands.
+ *
+ * @note Commands are encoded as variable-sized records into a bump arena made
+ *   of reusable blocks, so that a steady frame doesn't allocate once warmed up.
  */
-class CmdQueue {
+class CmdQueue : public NonCopyable {
 private:
-	typedef std::vector<CmdVariant> Cmds;
+	struct Block {
+		char* data = nullptr;
+		size_t size = 0;
+		size_t used = 0;
+	};
+	typedef std::vector<Block> Blocks;
+
+	static constexpr const size_t ALIGNMENT = alignof(std::max_align_t);
 
 private:
-	Cmds _cmds;
+	Blocks _blocks;
+	size_t _active = 0;
+	size_t _count = 0;
 
 public:
+	~CmdQueue() {
+		clear(true);
+	}
+
 	/**
-	 * @brief Transfers all commands from this queue to another queue.
+	 * @brief Marks all commands in the queue as transferred, so that one-shot
+	 *   commands won't be run again when the queue is replayed.
 	 */
-	void transferTo(CmdQueue &other) {
-		assert(other._cmds.empty());
-
-		other._cmds.reserve(_cmds.size());
-		for (int i = 0; i < (int)_cmds.size(); ++i) {
-			other._cmds.push_back(_cmds[i]);
-			_cmds[i].transfer();
-		}
+	void transfer(void) {
+		foreach(
+			[] (Cmd* cmd) -> void {
+				CmdVariant::transfer(cmd);
+			}
+		);
 	}
 	/**
-	 * @brief Runs through all commands in the queue.
+	 * @brief Applies the resource editing commands in the queue.
 	 */
-	void run(Primitives* primitives, Renderer* rnd, const Project* project, Resources* res, Audio* audio, const double* delta, unsigned frameId) {
-		for (CmdVariant &var : _cmds)
-			var.run(primitives, rnd, project, res, audio, delta, frameId);
+	void apply(void) {
+		foreach(
+			[] (Cmd* cmd) -> void {
+				CmdVariant::apply(cmd);
+			}
+		);
 	}
-
 	/**
-	 * @brief Takes all commands from another queue into this queue.
+	 * @brief Runs through all commands in the queue.
+	 *
+	 * @param[in, out] batch Merges consecutive texture draws when provided.
 	 */
-	void take(CmdQueue &other) {
-		std::copy(std::begin(other._cmds), std::end(other._cmds), std::back_inserter(_cmds));
-
-		other.clear(false);
+	void run(Primitives* primitives, Renderer* rnd, const Project* project, Resources* res, Audio* audio, const double* delta, unsigned frameId, CmdBatch* batch /* nullable */) {
+		foreach(
+			[&] (Cmd* cmd) -> void {
+				CmdVariant::run(cmd, primitives, rnd, project, res, audio, delta, frameId, batch);
+			}
+		);
+		if (batch)
+			batch->flush(rnd);
 	}
+
 	/**
-	 * @brief Adds a command into queue.
+	 * @brief Constructs a command at the end of queue.
+	 *
+	 * @param[in] extra Size of the payload in bytes that follows the command.
 	 */
-	void add(const CmdVariant &cmd) {
-		_cmds.push_back(cmd);
+	template<typename T, typename ...Args> T* add(size_t extra, Args &&...args) {
+		const size_t size = (sizeof(T) + extra + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+		T* result = new (allocate(size)) T(std::forward<Args>(args)...);
+		result->size = (unsigned)size;
+		++_count;
+
+		return result;
 	}
 	/**
 	 * @brief Gets command count.
 	 */
 	size_t size(void) const {
-		return _cmds.size();
+		return _count;
 	}
 
 	/**
 	 * @brief Clears all commands.
+	 *
+	 * @param[in] shrink Whether to release the arena blocks as well.
 	 */
 	void clear(bool shrink) {
-		_cmds.clear();
+		foreach(
+			[] (Cmd* cmd) -> void {
+				cmd->dtor(cmd);
+			}
+		);
+		for (Block &blk : _blocks)
+			blk.used = 0;
+		_active = 0;
+		_count = 0;
+
+		if (shrink) {
+			for (Block &blk : _blocks)
+				delete [] blk.data;
+			_blocks.clear();
+			_blocks.shrink_to_fit();
+		}
+	}
 
-		if (shrink)
-			_cmds.shrink_to_fit();
+private:
+	template<typename Handler> void foreach(Handler handler) {
+		for (Block &blk : _blocks) {
+			for (size_t offset = 0; offset < blk.used; ) {
+				Cmd* cmd = reinterpret_cast<Cmd*>(blk.data + offset);
+				offset += cmd->size;
+				handler(cmd);
+			}
+		}
+	}
+
+	void* allocate(size_t size) {
+		for (; _active < _blocks.size(); ++_active) {
+			Block &blk = _blocks[_active];
+			if (blk.used + size <= blk.size) {
+				void* result = blk.data + blk.used;
+				blk.used += size;
+
+				return result;
+			}
+		}
+
+		Block blk;
+		blk.size = std::max(size, (size_t)PRIMITIVES_FRAME_BLOCK_SIZE);
+		blk.data = new char[blk.size];
+		blk.used = size;
+		_blocks.push_back(blk);
+		_active = _blocks.size() - 1;
+
+		return blk.data;
 	}
 };
 
 /**
- * @brief Producer-consumer queue for primitive commands.
+ * @brief Single-producer single-consumer ring of command frames.
+ *
+ * @note The producer (code thread) fills the frame at `_committed` without
+ *   any lock, and publishes it by advancing `_committed`. The consumer
+ *   (graphics thread) always picks the latest published frame, and clears
+ *   the ones it has done with, so that commands are always destructed by the
+ *   graphics thread. The mutex and condition variable are only touched when
+ *   the producer has to wait for the consumer.
  */
 class CmdBuffer {
 private:
-	CmdQueue _consuming;
-	CmdQueue _producing;
-	CmdQueue _discarded;
+	CmdQueue _frames[PRIMITIVES_FRAME_COUNT];
+	CmdQueue* _producing = &_frames[0]; // By the producer.
+	CmdQueue* _consuming = nullptr; // By the consumer.
+
+	Atomic<unsigned> _committed; // Written by the producer.
+	Atomic<unsigned> _consumed; // Written by the consumer.
 
-	bool _blocking = false;
-	bool _syncing = false;
-	bool _forbidden = false;
+	bool _blocking = false; // By the producer.
+	Atomic<bool> _waiting;
+	Atomic<bool> _forbidden;
 
 	Mutex _lock;
+	std::condition_variable_any _cond;
 
 public:
+	CmdBuffer() : _committed(0), _consumed(0), _waiting(false), _forbidden(false) {
+	}
+
 	/**
-	 * @brief Consumes a queue of commands.
+	 * @brief Consumes the latest committed queue of commands.
+	 *
+	 * @return The queue to run, `nullptr` if nothing has been committed yet.
 	 */
-	void pop(CmdQueue &q) {
-		LockGuard<decltype(_lock)> guard(_lock);
+	CmdQueue* pop(void) {
+		const unsigned committed = _committed;
+		const unsigned consumed = _consumed;
+		if (committed != consumed) {
+			// Discard the previous frame and the stale ones that were never shown,
+			// resource editing in the stale ones still takes effect.
+			if (_consuming)
+				_consuming->clear(false);
+			for (unsigned i = consumed; i != committed - 1; ++i) {
+				CmdQueue &stale = _frames[i % PRIMITIVES_FRAME_COUNT];
+				stale.apply();
+				stale.clear(false);
+			}
+
+			_consuming = &_frames[(committed - 1) % PRIMITIVES_FRAME_COUNT];
+			_consumed = committed;
 
-		_consuming.transferTo(q);
-		_discarded.clear(false);
+			wake();
+		}
 
-		_syncing = false;
+		return _consuming;
 	}
 
 	/**
-	 * @brief Produces a command into queue.
+	 * @brief Gets the queue to produce commands into.
 	 */
-	void add(const CmdVariant &cmd) {
-		_producing.add(cmd);
+	CmdQueue &producing(void) {
+		return *_producing;
 	}
 	/**
-	 * @brief Produces a command into queue.
+	 * @brief Requires the next commit to wait until it's consumed.
 	 */
-	void add(const CmdVariant &cmd, bool block) {
-		_producing.add(cmd);
-
-		LockGuard<decltype(_lock)> guard(_lock);
-
-		_blocking |= block;
+	void block(void) {
+		_blocking = true;
 	}
 	/**
 	 * @brief Commits the producing queue to consuming, and gets ready for future producing.
 	 */
 	int commit(void) {
-		_lock.lock();
-
 		const bool blocking = _blocking;
 		_blocking = false;
-		if (blocking) {
-			_lock.unlock();
-
+		if (blocking)
 			return sync();
-		}
-
-		std::swap(_consuming, _producing);
-		_discarded.take(_producing);
-
-		const int result = (int)_consuming.size();
-
-		_lock.unlock();
 
-		return result;
+		return publish();
 	}
 	/**
 	 * @brief Synchronizes the producing queue to consuming, and waits until it's consumed.
 	 */
 	int sync(void) {
-		int result = 0;
-		do {
-			LockGuard<decltype(_lock)> guard(_lock);
+		if (_forbidden)
+			return 0;
 
-			if (_forbidden)
-				return result;
-
-			std::swap(_consuming, _producing);
-			_discarded.take(_producing);
+		const int result = publish();
 
-			result = (int)_consuming.size();
-
-			_syncing = true;
-		} while (false);
-
-		while (true) {
-			if (_lock.tryLock()) {
-				const bool syncing = _syncing;
-				_lock.unlock();
-				if (!syncing)
-					break;
+		await(
+			[this] (void) -> bool {
+				return _consumed == _committed;
 			}
-
-			constexpr const int STEP = 1;
-			DateTime::sleep(STEP);
-		}
+		);
 
 		return result;
 	}
@@ -2666,29 +3196,77 @@ public:
 	 * @brief Forbids command synchronizing.
 	 */
 	void forbid(void) {
-		LockGuard<decltype(_lock)> guard(_lock);
-
-		_consuming.clear(true);
-		_discarded.clear(true);
-
-		_blocking = false;
-		_syncing = false;
+		const unsigned committed = _committed;
+		if (_consuming)
+			_consuming->clear(true);
+		for (unsigned i = _consumed; i != committed; ++i)
+			_frames[i % PRIMITIVES_FRAME_COUNT].clear(true);
+
+		_consuming = nullptr;
+		_consumed = committed;
 		_forbidden = true;
+
+		wake();
 	}
 	/**
 	 * @brief Clears all queues.
+	 *
+	 * @note Both the producer and consumer must be idle.
 	 */
 	void reset(void) {
-		LockGuard<decltype(_lock)> guard(_lock);
+		for (int i = 0; i < PRIMITIVES_FRAME_COUNT; ++i)
+			_frames[i].clear(true);
+		_producing = &_frames[0];
+		_consuming = nullptr;
 
-		_consuming.clear(true);
-		_producing.clear(true);
-		_discarded.clear(true);
+		_committed = 0;
+		_consumed = 0;
 
 		_blocking = false;
-		_syncing = false;
+		_waiting = false;
 		_forbidden = false;
 	}
+
+private:
+	int publish(void) {
+		const int result = (int)_producing->size();
+		if (_forbidden)
+			return result;
+
+		const unsigned committed = _committed + 1;
+		_committed = committed;
+
+		// Wait until the consumer releases the next frame slot.
+		await(
+			[this, committed] (void) -> bool {
+				return committed - _consumed <= PRIMITIVES_FRAME_COUNT - 2;
+			}
+		);
+
+		_producing = &_frames[committed % PRIMITIVES_FRAME_COUNT];
+		assert(_producing->size() == 0 || _forbidden);
+
+		return result;
+	}
+
+	template<typename Pred> void await(Pred pred) {
+		if (pred())
+			return;
+
+		std::unique_lock<Mutex> guard(_lock);
+		_waiting = true;
+		while (!pred() && !_forbidden)
+			_cond.wait(guard);
+		_waiting = false;
+	}
+	void wake(void) {
+		if (!_waiting)
+			return;
+
+		LockGuard<decltype(_lock)> guard(_lock);
+
+		_cond.notify_one();
+	}
 };
 
 /* ===========================================================================} */
@@ -2741,7 +3319,9 @@ private:
 
 #if BITTY_MULTITHREAD_ENABLED
 	mutable CmdBuffer _buffer;
+	CmdBatch _batch; // By the graphics thread.
 #else /* BITTY_MULTITHREAD_ENABLED */
+	mutable CmdQueue _immediate;
 	mutable int _commited = 0;
 #endif /* BITTY_MULTITHREAD_ENABLED */
 	mutable unsigned _commands = 0;
@@ -2832,10 +3412,9 @@ public:
 	virtual void target(Resources::Texture::Ptr tex) override {
 		_canvasTarget = tex;
 
-		CmdVariant var;
-		new (&var.target) CmdTarget(tex);
+		CmdTarget* cmd = emplace<CmdTarget>(tex);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 
 	virtual bool autoCls(void) const override {
@@ -2850,39 +3429,35 @@ public:
 		if (col)
 			_clsColor = *col;
 
-		CmdVariant var;
-		new (&var.cls) CmdCls(_clsColor);
+		CmdCls* cmd = emplace<CmdCls>(_clsColor);
 
 		if (_autoCls)
-			commit(var, nullptr);
+			commit(cmd, nullptr);
 		else
-			commit(var, nullptr, true);
+			commit(cmd, nullptr, true);
 
 		return oldCol;
 	}
 	virtual void blend(Resources::Texture::Ptr tex, unsigned mode) override {
-		CmdVariant var;
-		new (&var.blend) CmdBlend(tex, (SDL_BlendMode)mode);
+		CmdBlend* cmd = emplace<CmdBlend>(tex, (SDL_BlendMode)mode);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void blend(unsigned mode) override {
 		_blend = mode;
 		_blendChanged = mode != SDL_BLENDMODE_BLEND;
 
-		CmdVariant var;
-		new (&var.blend) CmdBlend((SDL_BlendMode)mode);
+		CmdBlend* cmd = emplace<CmdBlend>((SDL_BlendMode)mode);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void blend(void) override {
 		_blend = SDL_BLENDMODE_BLEND;
 		_blendChanged = false;
 
-		CmdVariant var;
-		new (&var.blend) CmdBlend();
+		CmdBlend* cmd = emplace<CmdBlend>();
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual bool camera(int* x, int* y) const override {
 		if (x)
@@ -2953,13 +3528,12 @@ public:
 		if (culled(Math::Vec2i(x, y)))
 			return;
 
-		CmdVariant var;
-		new (&var.plot) CmdPlot(x, y, col ? *col : _color);
+		CmdPlot* cmd = emplace<CmdPlot>(x, y, col ? *col : _color);
 		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
 		if (clipped(clpX, clpY, clpW, clpH))
-			var.plot.clip(clpX, clpY, clpW, clpH);
+			cmd->clip(clpX, clpY, clpW, clpH);
 
-		commit(var, nullptr);
+		commit(cmd, nullptr);
 	}
 	virtual void line(int x0, int y0, int x1, int y1, const Color* col) const override {
 		translated(x0, y0);
@@ -2969,13 +3543,12 @@ public:
 		if (culled(aabb))
 			return;
 
-		CmdVariant var;
-		new (&var.line) CmdLine(x0, y0, x1, y1, col ? *col : _color);
+		CmdLine* cmd = emplace<CmdLine>(x0, y0, x1, y1, col ? *col : _color);
 		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
 		if (clipped(clpX, clpY, clpW, clpH))
-			var.line.clip(clpX, clpY, clpW, clpH);
+			cmd->clip(clpX, clpY, clpW, clpH);
 
-		commit(var, nullptr);
+		commit(cmd, nullptr);
 	}
 	virtual void circ(int x, int y, int r, bool fill, const Color* col) const override {
 		translated(x, y);
@@ -2984,13 +3557,12 @@ public:
 		if (culled(aabb))
 			return;
 
-		CmdVariant var;
-		new (&var.circ) CmdCirc(x, y, r, fill, col ? *col : _color);
+		CmdCirc* cmd = emplace<CmdCirc>(x, y, r, fill, col ? *col : _color);
 		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
 		if (clipped(clpX, clpY, clpW, clpH))
-			var.circ.clip(clpX, clpY, clpW, clpH);
+			cmd->clip(clpX, clpY, clpW, clpH);
 
-		commit(var, nullptr);
+		commit(cmd, nullptr);
 	}
 	virtual void ellipse(int x, int y, int rx, int ry, bool fill, const Color* col) const override {
 		translated(x, y);
@@ -2999,13 +3571,12 @@ public:
 		if (culled(aabb))
 			return;
 
-		CmdVariant var;
-		new (&var.ellipse) CmdEllipse(x, y, rx, ry, fill, col ? *col : _color);
+		CmdEllipse* cmd = emplace<CmdEllipse>(x, y, rx, ry, fill, col ? *col : _color);
 		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
 		if (clipped(clpX, clpY, clpW, clpH))
-			var.ellipse.clip(clpX, clpY, clpW, clpH);
+			cmd->clip(clpX, clpY, clpW, clpH);
 
-		commit(var, nullptr);
+		commit(cmd, nullptr);
 	}
 	virtual void pie(int x, int y, int r, int sa, int ea, bool fill, const Color* col) const override {
 		translated(x, y);
@@ -3014,13 +3585,12 @@ public:
 		if (culled(aabb))
 			return;
 
-		CmdVariant var;
-		new (&var.pie) CmdPie(x, y, r, sa, ea, fill, col ? *col : _color);
+		CmdPie* cmd = emplace<CmdPie>(x, y, r, sa, ea, fill, col ? *col : _color);
 		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
 		if (clipped(clpX, clpY, clpW, clpH))
-			var.pie.clip(clpX, clpY, clpW, clpH);
+			cmd->clip(clpX, clpY, clpW, clpH);
 
-		commit(var, nullptr);
+		commit(cmd, nullptr);
 	}
 	virtual void rect(int x0, int y0, int x1, int y1, bool fill, const Color* col, const int* rad) const override {
 		translated(x0, y0);
@@ -3030,13 +3600,12 @@ public:
 		if (culled(aabb))
 			return;
 
-		CmdVariant var;
-		new (&var.rect) CmdRect(x0, y0, x1, y1, fill, col ? *col : _color, rad);
+		CmdRect* cmd = emplace<CmdRect>(x0, y0, x1, y1, fill, col ? *col : _color, rad);
 		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
 		if (clipped(clpX, clpY, clpW, clpH))
-			var.rect.clip(clpX, clpY, clpW, clpH);
+			cmd->clip(clpX, clpY, clpW, clpH);
 
-		commit(var, nullptr);
+		commit(cmd, nullptr);
 	}
 	virtual void tri(const Math::Vec2f &p0, const Math::Vec2f &p1, const Math::Vec2f &p2, bool fill, const Color* col) const override {
 		Math::Vec2f p0_ = p0, p1_ = p1, p2_ = p2;
@@ -3049,13 +3618,12 @@ public:
 		if (culled(aabb))
 			return;
 
-		CmdVariant var;
-		new (&var.tri) CmdTri(p0_, p1_, p2_, fill, col ? *col : _color);
+		CmdTri* cmd = emplace<CmdTri>(p0_, p1_, p2_, fill, col ? *col : _color);
 		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
 		if (clipped(clpX, clpY, clpW, clpH))
-			var.tri.clip(clpX, clpY, clpW, clpH);
+			cmd->clip(clpX, clpY, clpW, clpH);
 
-		commit(var, nullptr);
+		commit(cmd, nullptr);
 	}
 	virtual void tri(const Math::Vec2f &p0, const Math::Vec2f &p1, const Math::Vec2f &p2, Resources::Texture::Ptr tex, const Math::Vec2f &uv0, const Math::Vec2f &uv1, const Math::Vec2f &uv2) const override {
 		if (!tex)
@@ -3071,25 +3639,61 @@ public:
 		if (culled(aabb))
 			return;
 
-		CmdVariant var;
-		new (&var.tri) CmdTri(p0_, p1_, p2_, tex, uv0, uv1, uv2);
+		CmdTri* cmd = emplace<CmdTri>(p0_, p1_, p2_, tex, uv0, uv1, uv2);
+		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
+		if (clipped(clpX, clpY, clpW, clpH))
+			cmd->clip(clpX, clpY, clpW, clpH);
+
+		commit(cmd, nullptr);
+	}
+	virtual void geometry(const Vertex* triangles, int triangleCount, const Vertex* lines, int lineCount) const override {
+		if (!triangles || triangleCount < 0)
+			triangleCount = 0;
+		if (!lines || lineCount < 0)
+			lineCount = 0;
+		if (triangleCount == 0 && lineCount == 0)
+			return;
+
+		int offsetX = 0, offsetY = 0;
+		translated(offsetX, offsetY);
+		offsetX = -offsetX;
+		offsetY = -offsetY;
+
+		float xMin = std::numeric_limits<float>::max(), yMin = std::numeric_limits<float>::max();
+		float xMax = std::numeric_limits<float>::lowest(), yMax = std::numeric_limits<float>::lowest();
+		auto bound = [&] (const Vertex* verts, int count) -> void {
+			for (int i = 0; i < count; ++i) {
+				xMin = std::min(xMin, verts[i].x);
+				yMin = std::min(yMin, verts[i].y);
+				xMax = std::max(xMax, verts[i].x);
+				yMax = std::max(yMax, verts[i].y);
+			}
+		};
+		bound(triangles, triangleCount * 3);
+		bound(lines, lineCount * 2);
+		const Math::Recti aabb(
+			(Int)std::floor(xMin) - offsetX, (Int)std::floor(yMin) - offsetY,
+			(Int)std::ceil(xMax) - offsetX, (Int)std::ceil(yMax) - offsetY
+		);
+		if (culled(aabb))
+			return;
+
+		CmdGeometry* cmd = queue().add<CmdGeometry>(sizeof(Vertex) * (triangleCount * 3 + lineCount * 2), triangles, triangleCount, lines, lineCount, offsetX, offsetY);
 		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
 		if (clipped(clpX, clpY, clpW, clpH))
-			var.tri.clip(clpX, clpY, clpW, clpH);
+			cmd->clip(clpX, clpY, clpW, clpH);
 
-		commit(var, nullptr);
+		commit(cmd, nullptr);
 	}
 	virtual void font(Font::Ptr font) override {
-		CmdVariant var;
-		new (&var.font) CmdFont(font);
+		CmdFont* cmd = emplace<CmdFont>(font);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void font(void) override {
-		CmdVariant var;
-		new (&var.font) CmdFont();
+		CmdFont* cmd = emplace<CmdFont>();
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual Math::Vec2f measure(const char* text, Font::Ptr font, int margin, const float* scale) const override {
 		Math::Vec2f result;
@@ -3142,14 +3746,14 @@ public:
 
 		translated(x, y);
 
-		CmdVariant var;
-		new (&var.text) CmdText(text, x, y, margin, scale);
+		const size_t extra = CmdText::decode(text, nullptr) * sizeof(Resources::Id);
+		CmdText* cmd = queue().add<CmdText>(extra, text, x, y, margin, scale);
 		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
 		if (clipped(clpX, clpY, clpW, clpH))
-			var.text.clip(clpX, clpY, clpW, clpH);
-		var.text.colored(col ? *col : _color);
+			cmd->clip(clpX, clpY, clpW, clpH);
+		cmd->colored(col ? *col : _color);
 
-		commit(var, nullptr);
+		commit(cmd, nullptr);
 	}
 	virtual void tex(Resources::Texture::Ptr tex, int x, int y, int width, int height, int sx, int sy, int swidth, int sheight, const double* rotAngle, const Math::Vec2f* rotCenter, bool hFlip, bool vFlip, const Color* col) const override {
 		translated(x, y);
@@ -3158,15 +3762,14 @@ public:
 		if ((!rotAngle || *rotAngle == 0) && width && height && culled(aabb))
 			return;
 
-		CmdVariant var;
-		new (&var.tex) CmdTex(tex, x, y, width, height, sx, sy, swidth, sheight, rotAngle, rotCenter, hFlip, vFlip);
+		CmdTex* cmd = emplace<CmdTex>(tex, x, y, width, height, sx, sy, swidth, sheight, rotAngle, rotCenter, hFlip, vFlip);
 		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
 		if (clipped(clpX, clpY, clpW, clpH))
-			var.tex.clip(clpX, clpY, clpW, clpH);
+			cmd->clip(clpX, clpY, clpW, clpH);
 		if (col)
-			var.tex.colored(*col);
+			cmd->colored(*col);
 
-		commit(var, nullptr);
+		commit(cmd, nullptr);
 	}
 	virtual void spr(Resources::Sprite::Ptr spr, int x, int y, int width, int height, const double* rotAngle, const Math::Vec2f* rotCenter, double delta, const Color* col) const override {
 		if (!spr)
@@ -3174,33 +3777,62 @@ public:
 
 		translated(x, y);
 
-		CmdVariant var;
-		new (&var.spr) CmdSpr(spr, x, y, width, height, rotAngle, rotCenter, delta);
+		CmdSpr* cmd = emplace<CmdSpr>(spr, x, y, width, height, rotAngle, rotCenter, delta);
 		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
 		if (clipped(clpX, clpY, clpW, clpH))
-			var.spr.clip(clpX, clpY, clpW, clpH);
+			cmd->clip(clpX, clpY, clpW, clpH);
 		if (col)
-			var.spr.colored(*col);
+			cmd->colored(*col);
 
-		commit(var, nullptr);
+		commit(cmd, nullptr);
+	}
+	virtual void texs(Resources::Texture::Ptr tex, int count, const InstanceFiller &fill) const override {
+		if (!fill || count <= 0)
+			return;
+
+		int offsetX = 0, offsetY = 0;
+		translated(offsetX, offsetY);
+		offsetX = -offsetX;
+		offsetY = -offsetY;
+
+		CmdTexs* cmd = queue().add<CmdTexs>(sizeof(Instance) * count, tex, count, fill, offsetX, offsetY);
+		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
+		if (clipped(clpX, clpY, clpW, clpH))
+			cmd->clip(clpX, clpY, clpW, clpH);
+
+		commit(cmd, nullptr);
+	}
+	virtual void sprs(Resources::Sprite::Ptr spr, int count, const InstanceFiller &fill, double delta) const override {
+		if (!spr || !fill || count <= 0)
+			return;
+
+		int offsetX = 0, offsetY = 0;
+		translated(offsetX, offsetY);
+		offsetX = -offsetX;
+		offsetY = -offsetY;
+
+		CmdSprs* cmd = queue().add<CmdSprs>(sizeof(Instance) * count, spr, count, fill, offsetX, offsetY, delta);
+		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
+		if (clipped(clpX, clpY, clpW, clpH))
+			cmd->clip(clpX, clpY, clpW, clpH);
+
+		commit(cmd, nullptr);
 	}
 	virtual void play(Resources::Sprite::Ptr spr, int begin, int end, bool reset, bool loop) const override {
 		if (!spr)
 			return;
 
-		CmdVariant var;
-		new (&var.playSpr) CmdPlaySpr(spr, begin, end, reset, loop);
+		CmdPlaySpr* cmd = emplace<CmdPlaySpr>(spr, begin, end, reset, loop);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void play(Resources::Sprite::Ptr spr, const std::string &key, bool reset, bool loop) const override {
 		if (!spr)
 			return;
 
-		CmdVariant var;
-		new (&var.playSpr) CmdPlaySpr(spr, key, reset, loop);
+		CmdPlaySpr* cmd = emplace<CmdPlaySpr>(spr, key, reset, loop);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void map(Resources::Map::Ptr map, int x, int y, double delta, const Color* col, int scale) const override {
 		if (!map)
@@ -3208,43 +3840,75 @@ public:
 
 		translated(x, y);
 
-		CmdVariant var;
-		new (&var.map) CmdMap(map, x, y, scale, delta);
+		CmdMap* cmd = emplace<CmdMap>(map, x, y, scale, delta);
 		int clpX = 0, clpY = 0, clpW = 0, clpH = 0;
 		if (clipped(clpX, clpY, clpW, clpH))
-			var.map.clip(clpX, clpY, clpW, clpH);
+			cmd->clip(clpX, clpY, clpW, clpH);
 		if (col)
-			var.map.colored(*col);
+			cmd->colored(*col);
 
-		commit(var, nullptr);
+		commit(cmd, nullptr);
 	}
-	virtual void pget(Resources::Palette::Ptr plt, int idx, Color &col) const override {
-		CmdVariant var;
-		new (&var.pget) CmdPGet(plt, idx);
+	virtual void pget(const Resources::Palette::Ptr &plt, int idx, Color &col) const override {
+		col = Color();
 
-		var.pget.wait(col);
+		const Palette::Ptr &shadow = CmdPGet::snapshot(plt);
+		if (shadow)
+			shadow->get(idx, col);
 	}
 	virtual void pset(Resources::Palette::Ptr plt, int idx, const Color &col) override {
-		CmdVariant var;
-		new (&var.pset) CmdPSet(plt, idx, col);
+		CmdPSet* cmd = emplace<CmdPSet>(plt, idx, col);
 
-		var.pset.wait();
+		cmd->wait();
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
-	virtual void mget(Resources::Map::Ptr map, int x, int y, int &cel) const override {
-		CmdVariant var;
-		new (&var.mget) CmdMGet(map, x, y);
-
-		var.mget.wait(cel);
+	virtual void mget(const Resources::Map::Ptr &map, int x, int y, int &cel) const override {
+		const Map::Ptr &shadow = CmdMGet::snapshot(map);
+		cel = shadow ? shadow->get(x, y) : Map::INVALID();
+	}
+	virtual Map::Ptr mget(Resources::Map::Ptr map) const override {
+		return CmdMGet::snapshot(map);
 	}
 	virtual void mset(Resources::Map::Ptr map, int x, int y, int cel) override {
-		CmdVariant var;
-		new (&var.mset) CmdMSet(map, x, y, cel);
+		CmdMSet* cmd = emplace<CmdMSet>(map, x, y, cel);
+
+		cmd->wait();
+
+		commit(cmd, nullptr);
+	}
+	virtual void mset(Resources::Map::Ptr map, int x, int y, int width, int height, int cel) override {
+		if (!clamped(map, x, y, width, height, nullptr, nullptr))
+			return;
+
+		CmdMSets* cmd = emplace<CmdMSets>(map, x, y, width, height, cel);
+
+		cmd->wait();
+
+		commit(cmd, nullptr);
+	}
+	virtual void mset(Resources::Map::Ptr map, int x, int y, int width, int height, const int* cels) override {
+		const int pitch = width;
+		int skipX = 0, skipY = 0;
+		if (!cels || !clamped(map, x, y, width, height, &skipX, &skipY))
+			return;
+
+		cels += skipX + (size_t)skipY * pitch;
+		CmdMSets* cmd = queue().add<CmdMSets>(sizeof(int) * (size_t)width * height, map, x, y, width, height, cels, pitch);
+
+		cmd->wait();
+
+		commit(cmd, nullptr);
+	}
+	virtual void mset(Resources::Map::Ptr map, const int* edits, int count) override {
+		if (!edits || count <= 0)
+			return;
+
+		CmdMSets* cmd = queue().add<CmdMSets>(sizeof(int) * count * 3, map, edits, count);
 
-		var.mset.wait();
+		cmd->wait();
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr);
 	}
 
 	virtual void volume(const Audio::SfxVolume &sfxVol, float musicVol) const override {
@@ -3253,91 +3917,81 @@ public:
 			sfxVol_[i] = std::min(sfxVol_[i], 1.0f);
 		musicVol = std::min(musicVol, 1.0f);
 
-		CmdVariant var;
-		new (&var.volume) CmdVolume(sfxVol, musicVol);
+		CmdVolume* cmd = emplace<CmdVolume>(sfxVol, musicVol);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void volume(float sfxVol, float musicVol) const override {
 		sfxVol = std::min(sfxVol, 1.0f);
 		musicVol = std::min(musicVol, 1.0f);
 
-		CmdVariant var;
-		new (&var.volume) CmdVolume(sfxVol, musicVol);
+		CmdVolume* cmd = emplace<CmdVolume>(sfxVol, musicVol);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void play(Resources::Sfx::Ptr sfx, bool loop, const int* fadeInMs, int channel) const override {
 		if (!sfx)
 			return;
 
-		CmdVariant var;
-		new (&var.playSfx) CmdPlaySfx(sfx, loop, fadeInMs, channel);
+		CmdPlaySfx* cmd = emplace<CmdPlaySfx>(sfx, loop, fadeInMs, channel);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void play(Resources::Music::Ptr mus, bool loop, const int* fadeInMs, const double* pos) const override {
 		if (!mus)
 			return;
 
-		CmdVariant var;
-		new (&var.playMusic) CmdPlayMusic(mus, loop, fadeInMs, pos);
+		CmdPlayMusic* cmd = emplace<CmdPlayMusic>(mus, loop, fadeInMs, pos);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void pause(Resources::Sfx::Ptr sfx) const override {
 		if (!sfx)
 			return;
 
-		CmdVariant var;
-		new (&var.pauseSfx) CmdPauseSfx(sfx);
+		CmdPauseSfx* cmd = emplace<CmdPauseSfx>(sfx);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void pause(Resources::Music::Ptr mus) const override {
 		if (!mus)
 			return;
 
-		CmdVariant var;
-		new (&var.pauseMusic) CmdPauseMusic(mus);
+		CmdPauseMusic* cmd = emplace<CmdPauseMusic>(mus);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void resume(Resources::Sfx::Ptr sfx) const override {
 		if (!sfx)
 			return;
 
-		CmdVariant var;
-		new (&var.resumeSfx) CmdResumeSfx(sfx);
+		CmdResumeSfx* cmd = emplace<CmdResumeSfx>(sfx);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void resume(Resources::Music::Ptr mus) const override {
 		if (!mus)
 			return;
 
-		CmdVariant var;
-		new (&var.resumeMusic) CmdResumeMusic(mus);
+		CmdResumeMusic* cmd = emplace<CmdResumeMusic>(mus);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void stop(Resources::Sfx::Ptr sfx, const int* fadeOutMs) const override {
 		if (!sfx)
 			return;
 
-		CmdVariant var;
-		new (&var.stopSfx) CmdStopSfx(sfx, fadeOutMs);
+		CmdStopSfx* cmd = emplace<CmdStopSfx>(sfx, fadeOutMs);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void stop(Resources::Music::Ptr mus, const int* fadeOutMs) const override {
 		if (!mus)
 			return;
 
-		CmdVariant var;
-		new (&var.stopMusic) CmdStopMusic(mus, fadeOutMs);
+		CmdStopMusic* cmd = emplace<CmdStopMusic>(mus, fadeOutMs);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 
 	virtual int btn(int btn, int idx) const override {
@@ -3353,10 +4007,9 @@ public:
 		return _input->controllerUp(btn, -idx - 1); // -1-based to 0-based.
 	}
 	virtual void rumble(int idx, int lowHz, int hiHz, unsigned ms) const override {
-		CmdVariant var;
-		new (&var.rumble) CmdRumble(idx, lowHz, hiHz, ms);
+		CmdRumble* cmd = emplace<CmdRumble>(idx, lowHz, hiHz, ms);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual bool key(int key) const override {
 		return _input->keyDown(key);
@@ -3368,22 +4021,20 @@ public:
 		return _input->mouse(btn, x, y, b0, b1, b2, wheelX, wheelY);
 	}
 	virtual void cursor(Image::Ptr img, float x, float y) const override {
-		CmdVariant var;
-		new (&var.cursor) CmdCursor(img, x, y);
+		CmdCursor* cmd = emplace<CmdCursor>(img, x, y);
 
-		commit(var, nullptr, true);
+		commit(cmd, nullptr, true);
 	}
 	virtual void function(Function func, const Variant &arg, bool block) const override {
 		if (!func)
 			return;
 
-		CmdVariant var;
-		new (&var.function) CmdFunction(func, arg);
+		CmdFunction* cmd = emplace<CmdFunction>(func, arg);
 
 		if (block)
-			commit(var, nullptr, block);
+			commit(cmd, nullptr, block);
 		else
-			commit(var, nullptr);
+			commit(cmd, nullptr);
 	}
 
 	virtual int newFrame(void) override {
@@ -3394,28 +4045,25 @@ public:
 #endif /* BITTY_MULTITHREAD_ENABLED */
 
 		if (_canvasTarget) {
-			CmdVariant var;
-			new (&var.target) CmdTarget(_canvasTarget);
+			CmdTarget* cmd = emplace<CmdTarget>(_canvasTarget);
 
-			commit(var, nullptr, true);
+			commit(cmd, nullptr, true);
 
 			++result;
 		}
 
 		if (_autoCls) {
-			CmdVariant var;
-			new (&var.cls) CmdCls(_clsColor);
+			CmdCls* cmd = emplace<CmdCls>(_clsColor);
 
-			commit(var, nullptr);
+			commit(cmd, nullptr);
 
 			++result;
 		}
 
 		if (_blendChanged) {
-			CmdVariant var;
-			new (&var.blend) CmdBlend((SDL_BlendMode)_blend);
+			CmdBlend* cmd = emplace<CmdBlend>((SDL_BlendMode)_blend);
 
-			commit(var, nullptr, true);
+			commit(cmd, nullptr, true);
 
 			++result;
 		}
@@ -3435,6 +4083,7 @@ public:
 		return _buffer.commit();
 #else /* BITTY_MULTITHREAD_ENABLED */
 		const int result = _commited;
+		_immediate.clear(false);
 		_commited = 0;
 		_commands = 0;
 
@@ -3649,6 +4298,7 @@ public:
 #if BITTY_MULTITHREAD_ENABLED
 		_buffer.reset();
 #else /* BITTY_MULTITHREAD_ENABLED */
+		_immediate.clear(true);
 		_commited = 0;
 #endif /* BITTY_MULTITHREAD_ENABLED */
 		_commands = 0;
@@ -3698,10 +4348,12 @@ public:
 			_audio->update(delta);
 		_input->update(_window, _renderer, clientArea, canvasSize, scale);
 
-		CmdQueue q;
-		_buffer.pop(q);
-		_commands = (unsigned)q.size();
-		q.run(this, _renderer, _project, _resources, _audio, &delta, _frameId);
+		CmdQueue* q = _buffer.pop();
+		_commands = q ? (unsigned)q->size() : 0;
+		if (q) {
+			q->run(this, _renderer, _project, _resources, _audio, &delta, _frameId, &_batch);
+			q->transfer();
+		}
 
 		restoreStates();
 #else /* BITTY_MULTITHREAD_ENABLED */
@@ -3752,6 +4404,40 @@ private:
 
 		return true;
 	}
+	bool clamped(Resources::Map::Ptr map, int &x, int &y, int &width, int &height, int* skipX /* nullable */, int* skipY /* nullable */) const {
+		if (!map || width <= 0 || height <= 0)
+			return false;
+
+		int mapWidth = 0, mapHeight = 0;
+		do {
+			LockGuard<Mutex> guard(map->lock);
+
+			const Map::Ptr &ptr = map->pointer;
+			if (!ptr)
+				return false;
+
+			mapWidth = ptr->width();
+			mapHeight = ptr->height();
+		} while (false);
+
+		const long long x0 = std::max((long long)x, 0ll);
+		const long long y0 = std::max((long long)y, 0ll);
+		const long long x1 = std::min((long long)x + width, (long long)mapWidth);
+		const long long y1 = std::min((long long)y + height, (long long)mapHeight);
+		if (x0 >= x1 || y0 >= y1)
+			return false;
+
+		if (skipX)
+			*skipX = (int)(x0 - x);
+		if (skipY)
+			*skipY = (int)(y0 - y);
+		x = (int)x0;
+		y = (int)y0;
+		width = (int)(x1 - x0);
+		height = (int)(y1 - y0);
+
+		return true;
+	}
 
 	void saveStates(void) {
 		// Save blend mode.
@@ -3768,26 +4454,37 @@ private:
 		_renderer->blend(_canvasBlend);
 	}
 
-	void commit(CmdVariant &var, const double* delta) const {
+	CmdQueue &queue(void) const {
 #if BITTY_MULTITHREAD_ENABLED
+		return _buffer.producing();
+#else /* BITTY_MULTITHREAD_ENABLED */
+		return _immediate;
+#endif /* BITTY_MULTITHREAD_ENABLED */
+	}
+	template<typename T, typename ...Args> T* emplace(Args &&...args) const {
+		return queue().add<T>(0, std::forward<Args>(args)...);
+	}
+	void commit(Cmd* cmd, const double* delta) const {
+#if BITTY_MULTITHREAD_ENABLED
+		(void)cmd;
 		(void)delta;
-
-		_buffer.add(var);
 #else /* BITTY_MULTITHREAD_ENABLED */
-		var.run(const_cast<PrimitivesImpl*>(this), _renderer, _project, _resources, _audio, delta, _frameId);
+		CmdVariant::run(cmd, const_cast<PrimitivesImpl*>(this), _renderer, _project, _resources, _audio, delta, _frameId, nullptr);
 		++_commited;
 		++_commands;
 #endif /* BITTY_MULTITHREAD_ENABLED */
 	}
-	void commit(CmdVariant &var, const double* delta, bool block) const {
+	void commit(Cmd* cmd, const double* delta, bool block) const {
 #if BITTY_MULTITHREAD_ENABLED
+		(void)cmd;
 		(void)delta;
 
-		_buffer.add(var, block);
+		if (block)
+			_buffer.block();
 #else /* BITTY_MULTITHREAD_ENABLED */
 		(void)block;
 
-		var.run(const_cast<PrimitivesImpl*>(this), _renderer, _project, _resources, _audio, delta, _frameId);
+		CmdVariant::run(cmd, const_cast<PrimitivesImpl*>(this), _renderer, _project, _resources, _audio, delta, _frameId, nullptr);
 		++_commited;
 		++_commands;
 #endif /* BITTY_MULTITHREAD_ENABLED */
@@ -52,6 +52,32 @@ class Primitives {
 public:
 	typedef std::function<void(const Variant &)> Function;
 
+	/**
+	 * @brief Placement of an instance for batched drawing.
+	 */
+	struct Instance {
+		int x = 0, y = 0, width = 0, height = 0;
+		int sx = 0, sy = 0, swidth = 0, sheight = 0; // Source area, for textures only.
+		float rotAngle = 0.0f; // In DEG.
+		Color color = Color(255, 255, 255, 255);
+	};
+	/**
+	 * @brief Fills the specific count of default instances in place.
+	 */
+	typedef std::function<void(Instance* /* out */, int /* count */)> InstanceFiller;
+	/**
+	 * @brief Colored vertex for batched geometry.
+	 */
+	struct Vertex {
+		float x = 0.0f, y = 0.0f;
+		Color color = Color(255, 255, 255, 255);
+
+		Vertex() {
+		}
+		Vertex(float x_, float y_, const Color &col) : x(x_), y(y_), color(col) {
+		}
+	};
+
 public:
 	/**
 	 * @brief Opens the primitives.
@@ -243,6 +269,16 @@ public:
 	 * @brief Draws a triangle, fills with the specific texture.
 	 */
 	virtual void tri(const Math::Vec2f &p0, const Math::Vec2f &p1, const Math::Vec2f &p2, Resources::Texture::Ptr tex, const Math::Vec2f &uv0, const Math::Vec2f &uv1, const Math::Vec2f &uv2) const = 0;
+	/**
+	 * @brief Draws filled triangles and line segments, as a single command.
+	 *
+	 * @param[in] triangles Every three vertices make a filled triangle.
+	 * @param[in] triangleCount Count of the triangles.
+	 * @param[in] lines Every two vertices make a line segment, drawn over the
+	 *   triangles.
+	 * @param[in] lineCount Count of the line segments.
+	 */
+	virtual void geometry(const Vertex* triangles /* nullable */, int triangleCount, const Vertex* lines /* nullable */, int lineCount) const = 0;
 	/**
 	 * @brief Sets the active font.
 	 *
@@ -277,6 +313,18 @@ public:
 	 * @param[in] rotAngle Rotation angle in DEG.
 	 */
 	virtual void spr(Resources::Sprite::Ptr spr, int x, int y, int width, int height, const double* rotAngle /* nullable */, const Math::Vec2f* rotCenter /* nullable */, double delta, const Color* col /* nullable */) const = 0;
+	/**
+	 * @brief Draws a texture for many instances, as a single command.
+	 *
+	 * @param[in] fill Writes the instances directly into the command.
+	 */
+	virtual void texs(Resources::Texture::Ptr tex /* nullable */, int count, const InstanceFiller &fill) const = 0;
+	/**
+	 * @brief Draws a sprite for many instances, as a single command.
+	 *
+	 * @param[in] fill Writes the instances directly into the command.
+	 */
+	virtual void sprs(Resources::Sprite::Ptr spr, int count, const InstanceFiller &fill, double delta) const = 0;
 	/**
 	 * @brief Plays the specific sprite, asynchronized.
 	 */
@@ -294,7 +342,7 @@ public:
 	 *
 	 * @param[out] col
 	 */
-	virtual void pget(Resources::Palette::Ptr plt, int idx, Color &col) const = 0;
+	virtual void pget(const Resources::Palette::Ptr &plt, int idx, Color &col) const = 0;
 	/**
 	 * @brief Sets the palette color at the specific index.
 	 *
@@ -306,13 +354,36 @@ public:
 	 *
 	 * @param[out] cel
 	 */
-	virtual void mget(Resources::Map::Ptr map, int x, int y, int &cel) const = 0;
+	virtual void mget(const Resources::Map::Ptr &map, int x, int y, int &cel) const = 0;
+	/**
+	 * @brief Gets a snapshot of the map to read cels directly from the
+	 *   executing thread, it reflects the `mset` calls immediately.
+	 *
+	 * @return The snapshot, or `nullptr` if the map is not loaded.
+	 */
+	virtual ::Map::Ptr mget(Resources::Map::Ptr map) const = 0;
 	/**
 	 * @brief Sets the map cel at the specific position.
 	 *
 	 * @param[in] cel
 	 */
 	virtual void mset(Resources::Map::Ptr map, int x, int y, int cel) = 0;
+	/**
+	 * @brief Fills an area of the map with the specific cel.
+	 */
+	virtual void mset(Resources::Map::Ptr map, int x, int y, int width, int height, int cel) = 0;
+	/**
+	 * @brief Copies cels to an area of the map.
+	 *
+	 * @param[in] cels Row-major, with `width * height` cels.
+	 */
+	virtual void mset(Resources::Map::Ptr map, int x, int y, int width, int height, const int* cels) = 0;
+	/**
+	 * @brief Applies a list of edits to the map.
+	 *
+	 * @param[in] edits With `count` edits, each one is `x, y, cel`.
+	 */
+	virtual void mset(Resources::Map::Ptr map, const int* edits, int count) = 0;
 
 	/**
 	 * @brief Sets the SFX and music volume values.
@@ -11,6 +11,7 @@
 #include "randomizer.h"
 #include <array>
 #include <cfloat>
+#include <cmath>
 #include <time.h>
 
 /*
@@ -109,6 +110,66 @@ public:
 		return integerToDouble(val);
 	}
 
+	virtual void fill(Int64* values, int count, Int64 low, Int64 up) override {
+		if (low > up)
+			std::swap(low, up);
+
+		const UInt64 n = (UInt64)up - (UInt64)low;
+		for (int i = 0; i < count; ++i) {
+			const UInt64 val = next(_state);
+			const UInt64 p = project(RANDOMIZER_I2UINT(val), n, _state);
+			values[i] = p + (UInt64)low;
+		}
+	}
+	virtual void fill(Double* values, int count, Double low, Double up, Kinds kind) override {
+		switch (kind) {
+		case GAUSSIAN:
+			// Box-Muller transform, generates a pair for every two uniform values.
+			for (int i = 0; i < count; i += 2) {
+				const Double u = 1 - integerToDouble(next(_state)); // (0, 1].
+				const Double v = integerToDouble(next(_state));
+				const Double r = std::sqrt(-2 * std::log(u)) * up;
+				const Double t = 2 * Math::PI() * v;
+				values[i] = low + r * std::cos(t);
+				if (i + 1 < count)
+					values[i + 1] = low + r * std::sin(t);
+			}
+
+			break;
+		default:
+			for (int i = 0; i < count; ++i)
+				values[i] = low + integerToDouble(next(_state)) * (up - low);
+
+			break;
+		}
+	}
+
+	virtual void jump(void) override {
+		static const UInt64 JUMP[] = {
+			0x180ec6d33cfd0abaull, 0xd5a61266f0c9392cull,
+			0xa9582618e03fc9aaull, 0x39abdc4529b1661cull
+		};
+
+		State state = { 0, 0, 0, 0 };
+		for (UInt64 j : JUMP) {
+			for (int b = 0; b < 64; ++b) {
+				if (j & ((UInt64)1 << b)) {
+					for (int i = 0; i < 4; ++i)
+						state[i] ^= _state[i];
+				}
+				next(_state);
+			}
+		}
+		_state = state;
+	}
+	virtual Randomizer* split(void) override {
+		RandomizerImpl* result = new RandomizerImpl();
+		result->_state = _state;
+		jump();
+
+		return result;
+	}
+
 private:
 	static UInt64 rotateLeft(UInt64 x, int n) {
 		return (x << n) | (RANDOMIZER_TRIM64(x) >> (64 - n));
@@ -29,6 +29,12 @@ public:
 
 	typedef std::pair<UInt64, UInt64> Seed;
 
+	enum Kinds {
+		INTEGER,
+		REAL,
+		GAUSSIAN
+	};
+
 public:
 	BITTY_CLASS_TYPE('R', 'A', 'N', 'D')
 
@@ -40,6 +46,35 @@ public:
 	virtual Int64 next(Int64 up) = 0;
 	virtual Double next(void) = 0;
 
+	/**
+	 * @brief Fills integers with uniform distribution in the range [low, up].
+	 *
+	 * @param[out] values
+	 */
+	virtual void fill(Int64* values, int count, Int64 low, Int64 up) = 0;
+	/**
+	 * @brief Fills reals with uniform distribution in the range [low, up) for
+	 *   `REAL`, or with normal distribution of mean `low` and standard
+	 *   deviation `up` for `GAUSSIAN`.
+	 *
+	 * @param[out] values
+	 */
+	virtual void fill(Double* values, int count, Double low, Double up, Kinds kind) = 0;
+
+	/**
+	 * @brief Advances the state by 2^128 steps, equivalent to that many calls
+	 *   to `next`.
+	 */
+	virtual void jump(void) = 0;
+	/**
+	 * @brief Derives an independent stream which continues from the current
+	 *   state, then jumps this one ahead; the sequences of the two don't
+	 *   overlap for 2^128 steps.
+	 *
+	 * @return A new randomizer to be destroyed by `Randomizer::destroy`.
+	 */
+	virtual Randomizer* split(void) = 0;
+
 	static Randomizer* create(void);
 	static void destroy(Randomizer* ptr);
 };
@@ -8,7 +8,10 @@
 ** For the latest info, see https://github.com/paladin-t/bitty/
 */
 
+#include "grid.h"
 #include "raycaster.h"
+#include "plus.h"
+#include <vector>
 
 /*
 ** {===========================================================================
@@ -19,6 +22,10 @@
 #	define RAYCASTER_MAX_LENGTH (BITTY_GRID_DEFAULT_SIZE * 256)
 #endif /* RAYCASTER_MAX_LENGTH */
 
+#ifndef RAYCASTER_PARALLEL_MIN_COUNT
+#	define RAYCASTER_PARALLEL_MIN_COUNT 256
+#endif /* RAYCASTER_PARALLEL_MIN_COUNT */
+
 /* ===========================================================================} */
 
 /*
@@ -63,6 +70,179 @@ public:
 		Math::Vec2f &intersectionPos, Math::Vec2i &intersectionIndex,
 		Real &intersectionDist, Directions &intersectionDir
 	) override {
+		BlockingHandler block = nullptr;
+		if (access.isLeft()) {
+			block = access.left().get();
+		} else {
+			EvaluationHandler eval = access.right().get();
+			block = [eval] (const Math::Vec2i &pos) -> bool {
+				return eval(pos) > 15;
+			};
+		}
+
+		return solve(
+			rayPos, rayDir,
+			block,
+			intersectionPos, intersectionIndex,
+			intersectionDist, intersectionDir
+		);
+	}
+	virtual int solve(
+		const Math::Vec2f &rayPos, const Math::Vec2f &rayDir,
+		const Grid* grid,
+		Math::Vec2f &intersectionPos, Math::Vec2i &intersectionIndex,
+		Real &intersectionDist, Directions &intersectionDir
+	) override {
+		if (!grid) {
+			intersectionPos = Math::Vec2f();
+			intersectionIndex = Math::Vec2i();
+			intersectionDist = 0;
+			intersectionDir = INVALID;
+
+			return 0;
+		}
+
+		auto block = [grid] (const Math::Vec2i &pos) -> bool {
+			return grid->get((int)pos.x, (int)pos.y);
+		};
+
+		return solve(
+			rayPos, rayDir,
+			block,
+			intersectionPos, intersectionIndex,
+			intersectionDist, intersectionDir
+		);
+	}
+	virtual int solve(
+		const Ray* rays, int count,
+		const AccessHandler &access, bool parallel,
+		Hit* hits
+	) override {
+		if (access.isLeft()) {
+			const BlockingHandler block = access.left().get();
+
+			return solve(rays, count, block, parallel, hits);
+		} else {
+			const EvaluationHandler eval = access.right().get();
+			auto block = [&eval] (const Math::Vec2i &pos) -> bool {
+				return eval(pos) > 15;
+			};
+
+			return solve(rays, count, block, parallel, hits);
+		}
+	}
+	virtual int solve(
+		const Ray* rays, int count,
+		const Grid* grid, bool parallel,
+		Hit* hits
+	) override {
+		if (!grid) {
+			for (int i = 0; i < count; ++i)
+				hits[i] = Hit();
+
+			return 0;
+		}
+
+		auto block = [grid] (const Math::Vec2i &pos) -> bool {
+			return grid->get((int)pos.x, (int)pos.y);
+		};
+
+		return solve(rays, count, block, parallel, hits);
+	}
+
+	virtual int fov(
+		const Math::Vec2i &origin, int radius,
+		const AccessHandler &access, int width, int height,
+		Byte* bits
+	) override {
+		if (access.isLeft()) {
+			const BlockingHandler block = access.left().get();
+
+			return fov(origin, radius, block, width, height, bits);
+		} else {
+			const EvaluationHandler eval = access.right().get();
+			auto block = [&eval] (const Math::Vec2i &pos) -> bool {
+				return eval(pos) > 15;
+			};
+
+			return fov(origin, radius, block, width, height, bits);
+		}
+	}
+	virtual int fov(
+		const Math::Vec2i &origin, int radius,
+		const Grid* grid,
+		Byte* bits
+	) override {
+		if (!grid)
+			return 0;
+
+		auto block = [grid] (const Math::Vec2i &pos) -> bool {
+			return grid->get((int)pos.x, (int)pos.y);
+		};
+
+		return fov(origin, radius, block, grid->width(), grid->height(), bits);
+	}
+
+private:
+	template<typename B> int solve(
+		const Ray* rays, int count,
+		const B &block, bool parallel,
+		Hit* hits
+	) {
+		auto proc = [this, rays, hits, &block] (int begin, int end) -> int {
+			int result = 0;
+			for (int i = begin; i < end; ++i) {
+				const Ray &ray = rays[i];
+				Hit &hit = hits[i];
+				Math::Vec2f intersectionPos;
+				Math::Vec2i intersectionIndex;
+				Real intersectionDist = 0;
+				Directions intersectionDir = INVALID;
+				const int ret = solve(
+					Math::Vec2f(ray.x, ray.y), Math::Vec2f(ray.dx, ray.dy),
+					block,
+					intersectionPos, intersectionIndex,
+					intersectionDist, intersectionDir
+				);
+				hit.x = (Single)intersectionPos.x;
+				hit.y = (Single)intersectionPos.y;
+				hit.ix = (Int32)intersectionIndex.x;
+				hit.iy = (Int32)intersectionIndex.y;
+				hit.distance = (Single)intersectionDist;
+				hit.direction = ret ? (Int32)intersectionDir : (Int32)INVALID;
+				if (ret)
+					++result;
+			}
+
+			return result;
+		};
+
+		const int n = Parallel::chunks(count, RAYCASTER_PARALLEL_MIN_COUNT, parallel);
+		if (n > 1) {
+			std::vector<int> results(n, 0);
+			Parallel::fork(
+				count, n,
+				[&proc, &results] (int chunk, int begin, int end) -> void {
+					results[chunk] = proc(begin, end);
+				}
+			);
+
+			int result = 0;
+			for (int r : results)
+				result += r;
+
+			return result;
+		}
+
+		return proc(0, count);
+	}
+
+	template<typename B> int solve(
+		const Math::Vec2f &rayPos, const Math::Vec2f &rayDir,
+		const B &block,
+		Math::Vec2f &intersectionPos, Math::Vec2i &intersectionIndex,
+		Real &intersectionDist, Directions &intersectionDir
+	) {
 		// Prepare.
 		intersectionPos = Math::Vec2f();
 		intersectionIndex = Math::Vec2i();
@@ -74,16 +254,6 @@ public:
 		if (rayDir == Math::Vec2f(0, 0))
 			return 0;
 
-		BlockingHandler block = nullptr;
-		if (access.isLeft()) {
-			block = access.left().get();
-		} else {
-			EvaluationHandler eval = access.right().get();
-			block = [eval] (const Math::Vec2i &pos) -> bool {
-				return eval(pos) > 15;
-			};
-		}
-
 		// Calculate ray position, index and direction.
 		Math::Vec2f dir = rayDir;
 		const Real len = std::min(dir.normalize(), (Real)RAYCASTER_MAX_LENGTH);
@@ -188,6 +358,109 @@ public:
 
 		return hit;
 	}
+
+	/**
+	 * @brief Recursive shadowcasting.
+	 *
+	 * @note See: http://www.roguebasin.com/index.php/FOV_using_recursive_shadowcasting.
+	 */
+	template<typename B> int fov(
+		const Math::Vec2i &origin, int radius,
+		const B &block, int width, int height,
+		Byte* bits
+	) {
+		// Octant multipliers: { xx, xy, yx, yy }.
+		constexpr const int OCTANTS[8][4] = {
+			{ 1, 0, 0, 1 }, { 0, 1, 1, 0 }, { 0, -1, 1, 0 }, { -1, 0, 0, 1 },
+			{ -1, 0, 0, -1 }, { 0, -1, -1, 0 }, { 0, 1, -1, 0 }, { 1, 0, 0, -1 }
+		};
+
+		if (width <= 0 || height <= 0)
+			return 0;
+
+		memset(bits, 0, ((size_t)width * height + 7) / 8);
+
+		const int ox = (int)origin.x;
+		const int oy = (int)origin.y;
+		if (ox < 0 || ox >= width || oy < 0 || oy >= height)
+			return 0;
+
+		if (radius <= 0)
+			radius = width + height;
+
+		int result = 0;
+		auto light = [&] (int x, int y) -> void {
+			const int i = x + y * width;
+			Byte &b = bits[i / 8];
+			const Byte m = (Byte)(1 << (i % 8));
+			if (b & m)
+				return;
+
+			b |= m;
+			++result;
+		};
+		auto opaque = [width, height, &block] (int x, int y) -> bool {
+			if (x < 0 || x >= width || y < 0 || y >= height)
+				return true;
+
+			return block(Math::Vec2i(x, y));
+		};
+
+		light(ox, oy);
+		for (int i = 0; i < 8; ++i) {
+			const int* oct = OCTANTS[i];
+			cast(ox, oy, 1, 1.0f, 0.0f, radius, oct[0], oct[1], oct[2], oct[3], width, height, opaque, light);
+		}
+
+		return result;
+	}
+	template<typename O, typename L> static void cast(
+		int ox, int oy, int row, float start, float end, int radius,
+		int xx, int xy, int yx, int yy,
+		int width, int height,
+		const O &opaque, const L &light
+	) {
+		if (start < end)
+			return;
+
+		const int radius2 = radius * radius;
+		float next = 0;
+		for (int j = row; j <= radius; ++j) {
+			bool blocked = false;
+			const int dy = -j;
+			for (int dx = -j; dx <= 0; ++dx) {
+				const float left = (dx - 0.5f) / (dy + 0.5f);
+				const float right = (dx + 0.5f) / (dy - 0.5f);
+				if (start < right)
+					continue;
+				else if (end > left)
+					break;
+
+				const int x = ox + dx * xx + dy * xy;
+				const int y = oy + dx * yx + dy * yy;
+				const bool inside = x >= 0 && x < width && y >= 0 && y < height;
+				if (inside && dx * dx + dy * dy <= radius2)
+					light(x, y);
+
+				const bool opq = opaque(x, y);
+				if (blocked) {
+					if (opq) {
+						next = right;
+
+						continue;
+					}
+					blocked = false;
+					start = next;
+				} else if (opq && j < radius) {
+					blocked = true;
+					cast(ox, oy, j + 1, start, left, radius, xx, xy, yx, yy, width, height, opaque, light);
+					next = right;
+				}
+			}
+			if (blocked)
+				break;
+		}
+	}
 };
 
 Raycaster* Raycaster::create(void) {
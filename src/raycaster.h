@@ -41,6 +41,29 @@ public:
 
 	typedef Either<BlockingHandler, EvaluationHandler> AccessHandler;
 
+	/**
+	 * @brief Ray for bulk casting, the length of the direction limits the
+	 *   distance.
+	 */
+	struct Ray {
+		Single x = 0;
+		Single y = 0;
+		Single dx = 0;
+		Single dy = 0;
+	};
+	/**
+	 * @brief Intersection for bulk casting, with `INVALID` direction if the
+	 *   ray didn't hit anything.
+	 */
+	struct Hit {
+		Single x = 0;
+		Single y = 0;
+		Int32 ix = 0;
+		Int32 iy = 0;
+		Single distance = 0;
+		Int32 direction = INVALID;
+	};
+
 public:
 	BITTY_CLASS_TYPE('R', 'C', 'S', 'T')
 
@@ -60,6 +83,64 @@ public:
 		Math::Vec2f &intersectionPos, Math::Vec2i &intersectionIndex,
 		Real &intersectionDist, Directions &intersectionDir
 	) = 0;
+	/**
+	 * @param[out] intersectionPos
+	 * @param[out] intersectionIndex
+	 */
+	virtual int solve(
+		const Math::Vec2f &rayPos, const Math::Vec2f &rayDir,
+		const class Grid* grid,
+		Math::Vec2f &intersectionPos, Math::Vec2i &intersectionIndex,
+		Real &intersectionDist, Directions &intersectionDir
+	) = 0;
+	/**
+	 * @brief Casts rays in bulk; splits them across threads if `parallel` is
+	 *   true and there are enough rays, then the access handler must be safe
+	 *   to be invoked from several threads.
+	 *
+	 * @param[out] hits
+	 * @return The count of the rays that hit.
+	 */
+	virtual int solve(
+		const Ray* rays, int count,
+		const AccessHandler &access, bool parallel,
+		Hit* hits
+	) = 0;
+	/**
+	 * @param[out] hits
+	 * @return The count of the rays that hit.
+	 */
+	virtual int solve(
+		const Ray* rays, int count,
+		const class Grid* grid, bool parallel,
+		Hit* hits
+	) = 0;
+
+	/**
+	 * @brief Computes the field of view from a tile with recursive
+	 *   shadowcasting; blocked tiles in sight are visible, positions out of
+	 *   the area are blocked.
+	 *
+	 * @param[in] radius In tiles, unlimited if it's not positive.
+	 * @param[out] bits One bit per tile in rows, from the least significant bit
+	 *   of each byte, `(width * height + 7) / 8` bytes; the same layout as
+	 *   `Grid::fromBits(...)`.
+	 * @return The count of the visible tiles.
+	 */
+	virtual int fov(
+		const Math::Vec2i &origin, int radius,
+		const AccessHandler &access, int width, int height,
+		Byte* bits
+	) = 0;
+	/**
+	 * @param[out] bits
+	 * @return The count of the visible tiles.
+	 */
+	virtual int fov(
+		const Math::Vec2i &origin, int radius,
+		const class Grid* grid,
+		Byte* bits
+	) = 0;
 
 	static Raycaster* create(void);
 	static void destroy(Raycaster* ptr);
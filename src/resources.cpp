@@ -13,8 +13,10 @@
 #include "file_handle.h"
 #include "font.h"
 #include "project.h"
+#include "renderer.h"
 #include "resources.h"
 #include "resource/inline_resource.h"
+#include <SDL.h>
 #include <unordered_map>
 
 /*
@@ -25,6 +27,16 @@
 static_assert(!std::numeric_limits<Resources::Id>::is_signed, "Wrong type.");
 static_assert(sizeof(Resources::Id) == sizeof(Font::Codepoint), "Wrong size.");
 
+#ifndef RESOURCES_GLYPH_ATLAS_PAGE_SIZE
+#	define RESOURCES_GLYPH_ATLAS_PAGE_SIZE 512
+#endif /* RESOURCES_GLYPH_ATLAS_PAGE_SIZE */
+#ifndef RESOURCES_GLYPH_ATLAS_MAX_PAGE_COUNT
+#	define RESOURCES_GLYPH_ATLAS_MAX_PAGE_COUNT 4
+#endif /* RESOURCES_GLYPH_ATLAS_MAX_PAGE_COUNT */
+#ifndef RESOURCES_GLYPH_ATLAS_MAX_COUNT
+#	define RESOURCES_GLYPH_ATLAS_MAX_COUNT 8
+#endif /* RESOURCES_GLYPH_ATLAS_MAX_COUNT */
+
 /* ===========================================================================} */
 
 /*
@@ -156,6 +168,246 @@ public:
 
 /* ===========================================================================} */
 
+/*
+** {===========================================================================
+** Glyph atlas
+*/
+
+/**
+ * @brief Dynamic glyph atlas of a font.
+ *
+ * @note Glyphs are rendered in white on demand and packed into a few pages by
+ *   the skyline bottom-left strategy, so that a whole string can be drawn from
+ *   the same texture and colored by vertices. The atlas starts over once all
+ *   its pages are full.
+ */
+class GlyphAtlas : public NonCopyable {
+public:
+	typedef std::shared_ptr<GlyphAtlas> Ptr;
+
+private:
+	struct Skyline {
+		int x = 0;
+		int y = 0;
+		int width = 0;
+
+		Skyline() {
+		}
+		Skyline(int x_, int y_, int width_) : x(x_), y(y_), width(width_) {
+		}
+	};
+	typedef std::vector<Skyline> Skylines;
+
+	struct Page {
+		::Texture::Ptr texture = nullptr;
+		int width = 0;
+		int height = 0;
+		Skylines skylines;
+
+		/**
+		 * @brief Finds a place for the specific size, and occupies it.
+		 */
+		bool pack(int w, int h, int* outX, int* outY) {
+			int best = -1;
+			int bestY = std::numeric_limits<int>::max();
+			int bestWidth = std::numeric_limits<int>::max();
+			for (int i = 0; i < (int)skylines.size(); ++i) {
+				const int y = fit(i, w, h);
+				if (y < 0)
+					continue;
+
+				if (y < bestY || (y == bestY && skylines[i].width < bestWidth)) {
+					best = i;
+					bestY = y;
+					bestWidth = skylines[i].width;
+				}
+			}
+			if (best < 0)
+				return false;
+
+			const int x = skylines[best].x;
+			skylines.insert(skylines.begin() + best, Skyline(x, bestY + h, w));
+			for (int i = best + 1; i < (int)skylines.size(); ) {
+				Skyline &prev = skylines[i - 1];
+				Skyline &curr = skylines[i];
+				if (curr.x >= prev.x + prev.width)
+					break;
+
+				const int shrink = prev.x + prev.width - curr.x;
+				curr.x += shrink;
+				curr.width -= shrink;
+				if (curr.width > 0)
+					break;
+
+				skylines.erase(skylines.begin() + i);
+			}
+			for (int i = 0; i + 1 < (int)skylines.size(); ) {
+				if (skylines[i].y == skylines[i + 1].y) {
+					skylines[i].width += skylines[i + 1].width;
+					skylines.erase(skylines.begin() + i + 1);
+				} else {
+					++i;
+				}
+			}
+
+			*outX = x;
+			*outY = bestY;
+
+			return true;
+		}
+
+	private:
+		int fit(int index, int w, int h) const {
+			const int x = skylines[index].x;
+			if (x + w > width)
+				return -1;
+
+			int y = skylines[index].y;
+			for (int i = index, left = w; left > 0; ++i) {
+				if (i >= (int)skylines.size())
+					return -1;
+
+				y = std::max(y, skylines[i].y);
+				if (y + h > height)
+					return -1;
+
+				left -= skylines[i].width;
+			}
+
+			return y;
+		}
+	};
+	typedef std::vector<Page> Pages;
+
+	struct Entry {
+		int page = -1; // Negative for unrenderable.
+		Math::Recti area;
+	};
+	typedef std::unordered_map<Font::Codepoint, Entry> Entries;
+
+private:
+	Font::Ptr _font = nullptr; // Also holds the font data.
+	Pages _pages;
+	Entries _entries;
+	Bytes* _glyph = nullptr;
+	unsigned long _ticks = 0;
+
+public:
+	GlyphAtlas(const Font* font) {
+		_font = Font::Ptr(Font::create());
+		_font->fromFont(font);
+		_glyph = Bytes::create();
+	}
+	~GlyphAtlas() {
+		Bytes::destroy(_glyph);
+		_glyph = nullptr;
+	}
+
+	unsigned long ticks(void) const {
+		return _ticks;
+	}
+	void ticks(unsigned long val) {
+		_ticks = val;
+	}
+
+	/**
+	 * @brief Gets the page that contains the specific glyph, renders and packs
+	 *   it if it's not in the atlas yet.
+	 *
+	 * @param[out] area
+	 */
+	::Texture::Ptr get(class Renderer* rnd, Font::Codepoint cp, Math::Recti* area) {
+		Entries::const_iterator it = _entries.find(cp);
+		if (it == _entries.end()) {
+			Entry entry;
+			do {
+				const Color WHITE(255, 255, 255, 255);
+				int width = -1;
+				int height = -1;
+				if (!_font->render(cp, _glyph, &WHITE, &width, &height))
+					break;
+				if (width <= 0 || height <= 0)
+					break;
+				assert(_glyph->count() == (size_t)width * height * sizeof(Color));
+
+				int page = -1;
+				int x = 0;
+				int y = 0;
+				if (!pack(rnd, width, height, &page, &x, &y))
+					break;
+
+				SDL_Texture* tex = (SDL_Texture*)_pages[page].texture->pointer(rnd);
+				const SDL_Rect rect{ x, y, width, height };
+				SDL_UpdateTexture(tex, &rect, _glyph->pointer(), width * sizeof(Color));
+
+				entry.page = page;
+				entry.area = Math::Recti::byXYWH(x, y, width, height);
+			} while (false);
+
+			it = _entries.insert(std::make_pair(cp, entry)).first;
+		}
+
+		const Entry &entry = it->second;
+		if (entry.page < 0)
+			return nullptr;
+
+		if (area)
+			*area = entry.area;
+
+		return _pages[entry.page].texture;
+	}
+
+private:
+	bool pack(class Renderer* rnd, int width, int height, int* page, int* x, int* y) {
+		// Prepare.
+		const int w = width + 1; // With 1px padding.
+		const int h = height + 1;
+
+		// Try the existing pages.
+		for (int i = 0; i < (int)_pages.size(); ++i) {
+			if (_pages[i].pack(w, h, x, y)) {
+				*page = i;
+
+				return true;
+			}
+		}
+
+		// Start over if the atlas is full.
+		if (_pages.size() >= RESOURCES_GLYPH_ATLAS_MAX_PAGE_COUNT) {
+			_pages.clear();
+			_entries.clear();
+		}
+
+		// Add a new page.
+		int pageWidth = std::max(w, RESOURCES_GLYPH_ATLAS_PAGE_SIZE);
+		int pageHeight = std::max(h, RESOURCES_GLYPH_ATLAS_PAGE_SIZE);
+		if (rnd->maxTextureWidth() > 0 && rnd->maxTextureHeight() > 0) {
+			pageWidth = std::min(pageWidth, rnd->maxTextureWidth());
+			pageHeight = std::min(pageHeight, rnd->maxTextureHeight());
+		}
+		if (w > pageWidth || h > pageHeight)
+			return false;
+
+		Page pg;
+		pg.texture = ::Texture::Ptr(::Texture::create());
+		std::vector<Byte> pixels((size_t)(pageWidth * pageHeight) * sizeof(Color), 0);
+		if (!pg.texture->fromBytes(rnd, ::Texture::STATIC, &pixels.front(), pageWidth, pageHeight, 0, ::Texture::NEAREST))
+			return false;
+		pg.texture->blend(::Texture::BLEND);
+		pg.width = pageWidth;
+		pg.height = pageHeight;
+		pg.skylines.push_back(Skyline(0, 0, pageWidth));
+		_pages.push_back(pg);
+
+		// Finish.
+		*page = (int)_pages.size() - 1;
+
+		return _pages.back().pack(w, h, x, y);
+	}
+};
+
+/* ===========================================================================} */
+
 /*
 ** {===========================================================================
 ** Resources
@@ -164,24 +416,34 @@ public:
 class ResourcesImpl : public Resources {
 private:
 	typedef std::unordered_map<ResourceKey, Object::Ptr, ResourceKey::Hash> Dictionary;
+	typedef std::unordered_map<uintptr_t, GlyphAtlas::Ptr> Atlases;
 
 private:
 	bool _opened = false;
 
 	Font::Ptr _font = nullptr;
+	Font::Ptr _defaultFont = nullptr;
 
 	Dictionary _dictionary;
 
+	Atlases _atlases;
+	GlyphAtlas::Ptr _atlas = nullptr; // The atlas of the current font.
+	uintptr_t _atlasFont = 0;
+	unsigned long _atlasTicks = 0;
+
 	static Id _idSeed;
 
 public:
 	ResourcesImpl() {
 		_font = Font::Ptr(Font::create());
+		_defaultFont = Font::Ptr(Font::create());
+		_defaultFont->fromBytes(RES_FONT_PROGGY_CLEAN, BITTY_COUNTOF(RES_FONT_PROGGY_CLEAN), RESOURCES_FONT_DEFAULT_SIZE, 0);
 	}
 	virtual ~ResourcesImpl() {
 		cleanup();
 
 		_font = nullptr;
+		_defaultFont = nullptr;
 	}
 
 	virtual bool open(void) override {
@@ -236,6 +498,21 @@ public:
 			}
 		}
 
+		const uintptr_t pointer = (uintptr_t)_font->pointer();
+		Atlases::iterator ait = _atlases.begin();
+		while (ait != _atlases.end()) {
+			if (ait->first == pointer) {
+				++ait;
+			} else {
+				ait = _atlases.erase(ait);
+				++result;
+			}
+		}
+		if (_atlasFont != pointer) {
+			_atlas = nullptr;
+			_atlasFont = 0;
+		}
+
 		const char* fmt = result > 1 ?
 			"Collected %d resources, retaining %d.\n" :
 			"Collected %d resource, retaining %d.\n";
@@ -245,9 +522,13 @@ public:
 		return result;
 	}
 	virtual int cleanup(void) override {
-		const int result = (int)_dictionary.size();
+		const int result = (int)(_dictionary.size() + _atlases.size());
 		_dictionary.clear();
 
+		_atlases.clear();
+		_atlas = nullptr;
+		_atlasFont = 0;
+
 		return result;
 	}
 
@@ -257,6 +538,10 @@ public:
 		const int dictCount = (int)_dictionary.size();
 		_dictionary.clear();
 
+		_atlases.clear();
+		_atlas = nullptr;
+		_atlasFont = 0;
+
 		_idSeed = 1;
 
 		const char* fmt = dictCount > 1 ?
@@ -293,10 +578,43 @@ public:
 		if (font_)
 			_font->fromFont(font_);
 		else
-			_font->fromBytes(RES_FONT_PROGGY_CLEAN, BITTY_COUNTOF(RES_FONT_PROGGY_CLEAN), RESOURCES_FONT_DEFAULT_SIZE, 0);
+			_font->fromFont(_defaultFont.get()); // Shares the default font data, to keep glyph caches valid.
 	}
 	virtual void font(std::nullptr_t) override {
-		_font->fromBytes(RES_FONT_PROGGY_CLEAN, BITTY_COUNTOF(RES_FONT_PROGGY_CLEAN), RESOURCES_FONT_DEFAULT_SIZE, 0);
+		_font->fromFont(_defaultFont.get());
+	}
+
+	virtual ::Texture::Ptr glyph(class Renderer* rnd, Id cp, Math::Recti* area) override {
+		if (area)
+			*area = Math::Recti();
+
+		if (!rnd)
+			return nullptr;
+
+		const uintptr_t pointer = (uintptr_t)_font->pointer();
+		if (!pointer)
+			return nullptr;
+
+		if (!_atlas || _atlasFont != pointer) {
+			Atlases::iterator it = _atlases.find(pointer);
+			if (it == _atlases.end()) {
+				if (_atlases.size() >= RESOURCES_GLYPH_ATLAS_MAX_COUNT) {
+					Atlases::iterator oldest = _atlases.begin();
+					for (it = _atlases.begin(); it != _atlases.end(); ++it) {
+						if (it->second->ticks() < oldest->second->ticks())
+							oldest = it;
+					}
+					_atlases.erase(oldest);
+				}
+
+				it = _atlases.insert(std::make_pair(pointer, GlyphAtlas::Ptr(new GlyphAtlas(_font.get())))).first;
+			}
+			_atlas = it->second;
+			_atlasFont = pointer;
+			_atlas->ticks(++_atlasTicks);
+		}
+
+		return _atlas->get(rnd, cp, area);
 	}
 
 	virtual ::Texture::Ptr load(class Renderer* rnd, const char* path) override {
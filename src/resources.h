@@ -375,6 +375,13 @@ public:
 	 * @param[out] width
 	 */
 	virtual ::Texture::Ptr load(class Renderer* rnd, Glyph &req, int* width /* nullable */, int* height /* nullable */) = 0;
+	/**
+	 * @brief Gets a glyph from the atlas of the current font.
+	 *
+	 * @param[out] area The area of the glyph in the returned texture.
+	 * @return The atlas page texture that contains the glyph, or `nullptr`.
+	 */
+	virtual ::Texture::Ptr glyph(class Renderer* rnd, Id cp, Math::Recti* area /* nullable */) = 0;
 	/**
 	 * @brief Loads palette from the project.
 	 *
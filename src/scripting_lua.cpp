@@ -32,6 +32,10 @@
 #	define SCRIPTING_LUA_WAIT_DURATION 16
 #endif /* SCRIPTING_LUA_WAIT_DURATION */
 
+#ifndef SCRIPTING_LUA_HOOK_COUNT
+#	define SCRIPTING_LUA_HOOK_COUNT 1000
+#endif /* SCRIPTING_LUA_HOOK_COUNT */
+
 #ifndef SCRIPTING_LUA_UNKNOWN_FRAME
 #	define SCRIPTING_LUA_UNKNOWN_FRAME "=?"
 #endif /* SCRIPTING_LUA_UNKNOWN_FRAME */
@@ -1078,9 +1082,8 @@ ScriptingLua* ScriptingLua::instanceOf(lua_State* L) {
 }
 
 bool ScriptingLua::hasBreakpoint(const char* src, int ln) const {
-	LockGuard<decltype(_breakpoints.lock)> guard(_breakpoints.lock);
-
-	if (_breakpoints.empty())
+	const Breakpoints::Bitmap* bitmap = _breakpoints.bitmap;
+	if (!bitmap)
 		return false;
 
 	if (src) {
@@ -1090,14 +1093,12 @@ bool ScriptingLua::hasBreakpoint(const char* src, int ln) const {
 			++src;
 	}
 
-	const Breakpoint* brk = _breakpoints.find(src, ln);
-
-	return !!brk;
+	return bitmap->test(src, ln);
 }
 
 void ScriptingLua::hookNormal(void) {
 #if BITTY_DEBUG_ENABLED
-	Lua::setHook(_L, hookNormal, LUA_MASKLINE, 0);
+	hookNormal(_L, !!_breakpoints.bitmap);
 #endif /* BITTY_DEBUG_ENABLED */
 }
 
@@ -1383,11 +1384,35 @@ int ScriptingLua::require(lua_State* L) {
 	return Lua::write(L, loader);
 }
 
+void ScriptingLua::hookNormal(lua_State* L, bool lines) {
+	// Only hooks every line when there's any breakpoint, otherwise a count
+	// hook is enough to check timeout and abort.
+	if (lines)
+		Lua::setHook(L, hookNormal, LUA_MASKLINE, 0);
+	else
+		Lua::setHook(L, hookNormal, LUA_MASKCOUNT, SCRIPTING_LUA_HOOK_COUNT);
+}
+
 void ScriptingLua::hookNormal(lua_State* L, lua_Debug* ar) {
 	ScriptingLua* impl = instanceOf(L);
 
-	Lua::getInfo(L, "Sl", ar);
-	if (impl->hasBreakpoint(ar->source, ar->currentline)) {
+	const Breakpoints::Bitmap* bitmap = impl->_breakpoints.bitmap;
+	if (bitmap != impl->_breakpoints.observed)
+		impl->_breakpoints.reclaim(bitmap); // A quiescent point, no older bitmap is being read.
+	bool hit = false;
+	if (ar->event == LUA_HOOKCOUNT) {
+		if (bitmap)
+			hookNormal(L, true); // Breakpoints added.
+	} else if (!bitmap) {
+		hookNormal(L, false); // Breakpoints cleared.
+	} else {
+		Lua::getInfo(L, "S", ar); // The current line is already filled for line event.
+		const char* src = ar->source;
+		if (src && (*src == '=' || *src == '@')) // Literal or file prefix.
+			++src;
+		hit = Breakpoints::Bitmap::test(bitmap->find(src), ar->currentline);
+	}
+	if (hit) {
 		if (impl->_state == RUNNING) {
 			impl->_state = PAUSED;
 
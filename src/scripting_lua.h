@@ -189,6 +189,7 @@ protected:
 
 	static int require(lua_State* L);
 
+	static void hookNormal(lua_State* L, bool lines);
 	static void hookNormal(lua_State* L, lua_Debug* ar);
 	static void hookBreak(lua_State* L, lua_Debug* ar);
 };
@@ -17,12 +17,14 @@
 #include "encoding.h"
 #include "file_handle.h"
 #include "filesystem.h"
+#include "grid.h"
 #include "network.h"
 #include "noiser.h"
 #include "pathfinder.h"
 #include "platform.h"
 #include "primitives.h"
 #include "project.h"
+#include "promise.h"
 #include "randomizer.h"
 #include "raycaster.h"
 #include "renderer.h"
@@ -54,10 +56,26 @@ static_assert(sizeof(Double) == sizeof(lua_Number), "Wrong size.");
 ** Utilities
 */
 
+namespace Lua { // Standard.
+
+/**< Promise. */
+
+LUA_CHECK_OBJ(Promise)
+LUA_READ_OBJ(Promise)
+LUA_WRITE_OBJ(Promise)
+LUA_WRITE_OBJ_CONST(Promise)
+
+}
+
 namespace Lua { // Library.
 
 /**< Algorithms. */
 
+LUA_CHECK_OBJ(Grid)
+LUA_READ_OBJ(Grid)
+LUA_WRITE_OBJ(Grid)
+LUA_WRITE_OBJ_CONST(Grid)
+
 LUA_CHECK_OBJ(Noiser)
 LUA_READ_OBJ(Noiser)
 LUA_WRITE_OBJ(Noiser)
@@ -253,6 +271,12 @@ LUA_READ_ALIAS(Resources::Music::Ptr, Music)
 LUA_WRITE_ALIAS(Resources::Music::Ptr, Music)
 LUA_WRITE_ALIAS_CONST(Resources::Music::Ptr, Music)
 
+namespace Engine {
+
+template<typename P, typename Q, typename R> static P Resources_waitUntilProcessed(Executable* exec, Primitives* primitives, Q &q, R r, unsigned y = P::element_type::TYPE());
+
+}
+
 /**< Palette. */
 
 LUA_CHECK_OBJ(Palette)
@@ -1259,6 +1283,165 @@ static int Noiser_get(lua_State* L) {
 	return 0;
 }
 
+static int Noiser_fill(lua_State* L) {
+	ScriptingLua* impl = ScriptingLua::instanceOf(L);
+
+	const int n = getTop(L);
+	Noiser::Ptr* obj = nullptr;
+	Placeholder _2;
+	Math::Recti* rect = nullptr;
+	Math::Vec2f* scale = nullptr;
+	Math::Vec2f* offset = nullptr;
+	if (n >= 5)
+		read<>(L, obj, _2, rect, scale, offset);
+	else if (n >= 4)
+		read<>(L, obj, _2, rect, scale);
+	else
+		read<>(L, obj, _2, rect);
+
+	Bytes::Ptr* bytes = nullptr;
+	Image::Ptr* img = nullptr;
+	Resources::Map::Ptr* map = nullptr;
+	read<2>(L, bytes);
+	if (!bytes)
+		read<2>(L, img);
+	if (!bytes && !img)
+		read<2>(L, map);
+
+	std::vector<Real> thresholds;
+	if (n >= 6 && isTable(L, 6)) {
+		const int count = (int)len(L, 6);
+		thresholds.resize(count);
+		for (int i = 0; i < count; ++i) {
+			get(L, 6, i + 1); // 1-based.
+			thresholds[i] = (Real)lua_tonumber(L, -1);
+			pop(L);
+		}
+		std::sort(thresholds.begin(), thresholds.end());
+	}
+
+	if (!obj || !rect)
+		return 0;
+
+	if (!bytes && !img && !map) {
+		error(L, "Bytes, image or map resource argument(2) expected.");
+
+		return 0;
+	}
+	if (map && thresholds.empty()) {
+		error(L, "Thresholds expected.");
+
+		return 0;
+	}
+
+	// Clips the area to the target image or map, so that an oversize or
+	// negative rect neither overflows the value count nor allocates more
+	// than the target could hold; bytes have no bounds, so cap the area.
+	constexpr const long long MAX_AREA = 4096ll * 4096ll;
+	long long x0 = rect->xMin();
+	long long y0 = rect->yMin();
+	long long x1 = (long long)rect->xMax() + 1;
+	long long y1 = (long long)rect->yMax() + 1;
+	if (bytes) {
+		if (!bytes->get())
+			return 0;
+	} else if (img) {
+		if (!img->get())
+			return 0;
+
+		x0 = std::max(x0, 0ll);
+		y0 = std::max(y0, 0ll);
+		x1 = std::min(x1, (long long)(*img)->width());
+		y1 = std::min(y1, (long long)(*img)->height());
+	} else /* if (map) */ {
+		if (!*map)
+			return 0;
+
+		Engine::Resources_waitUntilProcessed<Map::Ptr>(impl, impl->primitives(), *map, (*map)->ref);
+
+		int mapWidth = 0, mapHeight = 0;
+		do {
+			LockGuard<Mutex> guard((*map)->lock);
+
+			const Map::Ptr &ptr = (*map)->pointer;
+			if (!ptr)
+				return 0;
+
+			mapWidth = ptr->width();
+			mapHeight = ptr->height();
+		} while (false);
+
+		x0 = std::max(x0, 0ll);
+		y0 = std::max(y0, 0ll);
+		x1 = std::min(x1, (long long)mapWidth);
+		y1 = std::min(y1, (long long)mapHeight);
+	}
+	const long long w_ = std::max(x1 - x0, 0ll);
+	const long long h_ = std::max(y1 - y0, 0ll);
+	if (h_ > 0 && w_ > MAX_AREA / h_) {
+		error(L, "Area too large.");
+
+		return 0;
+	}
+
+	const int x = (int)x0;
+	const int y = (int)y0;
+	const int w = (int)w_;
+	const int h = (int)h_;
+	const size_t count = (size_t)w * h;
+	std::vector<Single> values(count);
+	if (count > 0) {
+		obj->get()->fill(
+			Math::Recti(x, y, x + w - 1, y + h - 1), scale ? *scale : Math::Vec2f(1, 1), offset ? *offset : Math::Vec2f(0, 0),
+			true,
+			&values.front()
+		);
+	}
+
+	auto pick = [&thresholds] (Single val) -> int {
+		return (int)(std::upper_bound(thresholds.begin(), thresholds.end(), (Real)val) - thresholds.begin());
+	};
+
+	if (bytes) {
+		(*bytes)->resize(count * sizeof(Single));
+		if (count > 0)
+			memcpy((*bytes)->pointer(), &values.front(), count * sizeof(Single));
+		(*bytes)->poke(0);
+
+		return write(L, bytes);
+	} else if (img) {
+		Image* ptr = img->get();
+		const int paletted = ptr->paletted(); // Bit depth, 0 for true color.
+		const int colors = paletted ? 1 << paletted : 0;
+		for (int j = 0; j < h; ++j) {
+			for (int i = 0; i < w; ++i) {
+				const Single val = values[i + (size_t)j * w];
+				const Single t = Math::clamp((val + 1) * 0.5f, 0.0f, 1.0f);
+				if (paletted) {
+					const int index = thresholds.empty() ?
+						std::min((int)(t * colors), colors - 1) :
+						std::min(pick(val), colors - 1);
+					ptr->set(x + i, y + j, index);
+				} else {
+					const Byte g = (Byte)(t * 255);
+					ptr->set(x + i, y + j, Color(g, g, g, 255));
+				}
+			}
+		}
+
+		return write(L, img);
+	} else /* if (map) */ {
+		std::vector<int> cels(count);
+		for (size_t i = 0; i < count; ++i)
+			cels[i] = pick(values[i]);
+
+		if (count > 0)
+			impl->primitives()->mset(*map, x, y, w, h, &cels.front());
+
+		return write(L, map);
+	}
+}
+
 static int Noiser_domainWarp(lua_State* L) {
 	const int n = getTop(L);
 	Noiser::Ptr* obj = nullptr;
@@ -1308,6 +1491,7 @@ static void open_Noiser(lua_State* L) {
 			luaL_Reg{ "setOption", Noiser_setOption },
 			luaL_Reg{ "seed", Noiser_seed },
 			luaL_Reg{ "get", Noiser_get },
+			luaL_Reg{ "fill", Noiser_fill },
 			luaL_Reg{ "domainWarp", Noiser_domainWarp },
 			luaL_Reg{ nullptr, nullptr }
 		),
@@ -1372,8 +1556,11 @@ static int Pathfinder_solve(lua_State* L) {
 	Pathfinder::Ptr* obj = nullptr;
 	Math::Vec2i begin, end;
 	Function::Ptr eval = nullptr;
-	if (n >= 4)
+	Grid::Ptr* grid = nullptr;
+	if (n >= 4 && isFunction(L, 4))
 		read<>(L, obj, begin, end, eval);
+	else if (n >= 4)
+		read<>(L, obj, begin, end, grid);
 	else
 		read<>(L, obj, begin, end);
 
@@ -1396,6 +1583,13 @@ static int Pathfinder_solve(lua_State* L) {
 			};
 		}
 
+		if (grid) {
+			if (!obj->get()->solve(begin, end, grid->get(), path, &cost))
+				return write(L, path, cost);
+
+			return write(L, path, cost); // Undocumented: secondary value.
+		}
+
 		if (!obj->get()->solve(begin, end, eval_, path, &cost))
 			return write(L, path, cost);
 
@@ -1405,6 +1599,193 @@ static int Pathfinder_solve(lua_State* L) {
 	return 0;
 }
 
+/**
+ * @brief Takes the result of an asynchronous solving from any thread, and
+ *   settles the promise with it on the Lua thread.
+ */
+class PathfinderPending : public Updatable {
+public:
+	typedef std::shared_ptr<PathfinderPending> Ptr;
+
+private:
+	Promise* _promise = nullptr; // Foreign, it removes this from the updatables before being destroyed.
+	bool _settled = false; // By the Lua thread.
+
+	Pathfinder::Result::Ptr _result = nullptr;
+	bool _solved = false;
+	Mutex _lock;
+
+public:
+	PathfinderPending(Promise* promise) : _promise(promise) {
+	}
+
+	virtual bool update(double) override {
+		if (_settled)
+			return false;
+
+		Pathfinder::Result::Ptr result = nullptr;
+		do {
+			LockGuard<decltype(_lock)> guard(_lock);
+
+			if (!_solved)
+				return true;
+
+			result = _result;
+			_result = nullptr;
+		} while (false);
+
+		_settled = true;
+		if (result)
+			_promise->resolve(Variant(result));
+		else
+			_promise->reject("Canceled.");
+
+		return false;
+	}
+
+	void solved(Pathfinder::Result::Ptr result /* nullable */) {
+		LockGuard<decltype(_lock)> guard(_lock);
+
+		_result = result;
+		_solved = true;
+	}
+};
+
+static int Pathfinder_solveAsync(lua_State* L) {
+	ScriptingLua* impl = ScriptingLua::instanceOf(L);
+
+	const int n = getTop(L);
+	Pathfinder::Ptr* obj = nullptr;
+	Math::Vec2i begin, end;
+	Grid::Ptr* grid = nullptr;
+	if (n >= 4)
+		read<>(L, obj, begin, end, grid);
+	else
+		read<>(L, obj, begin, end);
+
+	if (obj) {
+		Promise* promise = Promise::create();
+		if (!promise)
+			return write(L, nullptr);
+
+		PathfinderPending::Ptr pending(new PathfinderPending(promise));
+		Promise::Ptr ret(
+			promise,
+			std::bind(
+				[impl] (Promise* promise, PathfinderPending::Ptr pending) -> void {
+					impl->removeUpdatable(pending.get());
+					impl->removeUpdatable(promise);
+
+					promise->clear();
+
+					Promise::destroy(promise);
+				},
+				std::placeholders::_1, pending
+			)
+		);
+
+		impl->addUpdatable(pending.get()); // Settles before the promise updates.
+		impl->addUpdatable(ret.get());
+
+		// The workers only touch the pending slot, the promise is owned by the
+		// Lua thread.
+		obj->get()->solveAsync(
+			begin, end,
+			grid ? grid->get() : nullptr,
+			std::bind(
+				[] (PathfinderPending::Ptr pending, Pathfinder::Result::Ptr result) -> void {
+					pending->solved(result);
+				},
+				pending, std::placeholders::_1
+			)
+		);
+
+		return write(L, &ret);
+	}
+
+	return 0;
+}
+
+static int Pathfinder_cancel(lua_State* L) {
+	Pathfinder::Ptr* obj = nullptr;
+	read<>(L, obj);
+
+	if (obj) {
+		const int ret = obj->get()->cancel(0);
+
+		return write(L, ret);
+	}
+
+	return 0;
+}
+
+static int Pathfinder_flow(lua_State* L) {
+	Pathfinder::Ptr* obj = nullptr;
+	read<>(L, obj);
+
+	if (obj) {
+		Math::Vec2i::List goals;
+		if (isTable(L, 2)) {
+			const int count = (int)len(L, 2);
+			for (int i = 0; i < count; ++i) {
+				get(L, 2, i + 1); // 1-based.
+				Math::Vec2i goal;
+				read(L, goal, Index(getTop(L)));
+				goals.push_back(goal);
+				pop(L);
+			}
+		} else {
+			Math::Vec2i goal;
+			read<2>(L, goal);
+			goals.push_back(goal);
+		}
+
+		const bool ret = obj->get()->flow(goals);
+
+		return write(L, ret);
+	}
+
+	return 0;
+}
+
+static int Pathfinder_step(lua_State* L) {
+	Pathfinder::Ptr* obj = nullptr;
+	Math::Vec2i pos;
+	read<>(L, obj, pos);
+
+	if (obj) {
+		Math::Vec2i next;
+		float cost = 0;
+		if (!obj->get()->step(pos, next, &cost))
+			return write(L, nullptr);
+
+		return write(L, next, cost);
+	}
+
+	return 0;
+}
+
+static int Pathfinder_field(lua_State* L) {
+	Pathfinder::Ptr* obj = nullptr;
+	Bytes::Ptr* bytes = nullptr;
+	read<>(L, obj, bytes);
+
+	if (obj && bytes && bytes->get()) {
+		const size_t size = obj->get()->field(nullptr, 0);
+		if (size == 0)
+			return write(L, false);
+
+		Bytes* buf = bytes->get();
+		buf->resize(size);
+		obj->get()->field(buf->pointer(), size);
+		buf->poke(0);
+
+		return write(L, true);
+	}
+
+	return 0;
+}
+
 static int Pathfinder___index(lua_State* L) {
 	Pathfinder::Ptr* obj = nullptr;
 	const char* field = nullptr;
@@ -1413,7 +1794,11 @@ static int Pathfinder___index(lua_State* L) {
 	if (!obj || !field)
 		return 0;
 
-	if (strcmp(field, "diagonalCost") == 0) {
+	if (strcmp(field, "mode") == 0) {
+		const Enum ret = (Enum)obj->get()->mode();
+
+		return write(L, ret);
+	} else if (strcmp(field, "diagonalCost") == 0) {
 		const float ret = obj->get()->diagonalCost();
 		if (!ret)
 			return write(L, 0);
@@ -1432,7 +1817,12 @@ static int Pathfinder___newindex(lua_State* L) {
 	if (!obj || !field)
 		return 0;
 
-	if (strcmp(field, "diagonalCost") == 0) {
+	if (strcmp(field, "mode") == 0) {
+		Enum val = (Enum)Pathfinder::DEFAULT;
+		read<3>(L, val);
+
+		obj->get()->mode((Pathfinder::Modes)val);
+	} else if (strcmp(field, "diagonalCost") == 0) {
 		float val = 1.414f;
 		read<3>(L, val);
 
@@ -1461,10 +1851,24 @@ static void open_Pathfinder(lua_State* L) {
 			luaL_Reg{ "set", Pathfinder_set },
 			luaL_Reg{ "clear", Pathfinder_clear },
 			luaL_Reg{ "solve", Pathfinder_solve },
+			luaL_Reg{ "solveAsync", Pathfinder_solveAsync },
+			luaL_Reg{ "cancel", Pathfinder_cancel },
+			luaL_Reg{ "flow", Pathfinder_flow },
+			luaL_Reg{ "step", Pathfinder_step },
+			luaL_Reg{ "field", Pathfinder_field },
 			luaL_Reg{ nullptr, nullptr }
 		),
 		Pathfinder___index, Pathfinder___newindex
 	);
+
+	getGlobal(L, "Pathfinder");
+	setTable(
+		L,
+		"Default", (Enum)Pathfinder::DEFAULT,
+		"JumpPoint", (Enum)Pathfinder::JUMP_POINT,
+		"Hierarchical", (Enum)Pathfinder::HIERARCHICAL
+	);
+	pop(L);
 }
 
 static int Random_ctor(lua_State* L) {
@@ -1533,6 +1937,97 @@ static int Random_next(lua_State* L) {
 	return 0;
 }
 
+static int Random_fill(lua_State* L) {
+	const int n = getTop(L);
+	Randomizer::Ptr* obj = nullptr;
+	Bytes::Ptr* bytes = nullptr;
+	int count = 0;
+	Enum kind = (Enum)Randomizer::REAL;
+	if (n >= 4)
+		read<>(L, obj, bytes, count, kind);
+	else
+		read<>(L, obj, bytes, count);
+
+	if (!obj)
+		return 0;
+
+	if (!bytes || !bytes->get()) {
+		error(L, "Bytes expected.");
+
+		return 0;
+	}
+
+	count = std::max(count, 0);
+	switch ((Randomizer::Kinds)kind) {
+	case Randomizer::INTEGER: {
+			Int64 low = 0;
+			Int64 up = 0;
+			read<5>(L, low);
+			read<6>(L, up);
+
+			std::vector<Int64> values(count);
+			if (count > 0)
+				obj->get()->fill(&values.front(), count, low, up);
+
+			(*bytes)->resize(count * sizeof(Int64));
+			if (count > 0)
+				memcpy((*bytes)->pointer(), &values.front(), count * sizeof(Int64));
+		}
+
+		break;
+	case Randomizer::REAL: // Fall through.
+	case Randomizer::GAUSSIAN: {
+			Double low = 0;
+			Double up = 1;
+			if (n >= 5)
+				read<5>(L, low);
+			if (n >= 6)
+				read<6>(L, up);
+
+			std::vector<Double> values(count);
+			if (count > 0)
+				obj->get()->fill(&values.front(), count, low, up, (Randomizer::Kinds)kind);
+
+			(*bytes)->resize(count * sizeof(Double));
+			if (count > 0)
+				memcpy((*bytes)->pointer(), &values.front(), count * sizeof(Double));
+		}
+
+		break;
+	default:
+		error(L, "Invalid kind.");
+
+		return 0;
+	}
+	(*bytes)->poke(0);
+
+	return write(L, bytes);
+}
+
+static int Random_jump(lua_State* L) {
+	Randomizer::Ptr* obj = nullptr;
+	read<>(L, obj);
+
+	if (obj)
+		obj->get()->jump();
+
+	return 0;
+}
+
+static int Random_split(lua_State* L) {
+	Randomizer::Ptr* obj = nullptr;
+	read<>(L, obj);
+
+	if (!obj)
+		return 0;
+
+	Randomizer::Ptr ret(obj->get()->split());
+	if (!ret)
+		return write(L, nullptr);
+
+	return write(L, &ret);
+}
+
 static void open_Random(lua_State* L) {
 	def(
 		L, "Random",
@@ -1550,10 +2045,22 @@ static void open_Random(lua_State* L) {
 		array(
 			luaL_Reg{ "seed", Random_seed },
 			luaL_Reg{ "next", Random_next },
+			luaL_Reg{ "fill", Random_fill },
+			luaL_Reg{ "jump", Random_jump },
+			luaL_Reg{ "split", Random_split },
 			luaL_Reg{ nullptr, nullptr }
 		),
 		nullptr, nullptr
 	);
+
+	getGlobal(L, "Random");
+	setTable(
+		L,
+		"Integer", (Enum)Randomizer::INTEGER,
+		"Real", (Enum)Randomizer::REAL,
+		"Gaussian", (Enum)Randomizer::GAUSSIAN
+	);
+	pop(L);
 }
 
 static int Raycaster_ctor(lua_State* L) {
@@ -1577,10 +2084,13 @@ static int Raycaster_solve(lua_State* L) {
 
 	Function::Ptr block = nullptr;
 	Resources::Map::Ptr* map = nullptr;
+	Grid::Ptr* grid = nullptr;
 	if (isFunction(L, 4))
 		read<4>(L, block);
 	else
 		read<4>(L, map);
+	if (!block && !map)
+		read<4>(L, grid);
 
 	if (!obj)
 		return 0;
@@ -1588,12 +2098,30 @@ static int Raycaster_solve(lua_State* L) {
 	if (!rayPos || !rayDir)
 		return 0;
 
-	if (!block && !map) {
-		error(L, "Function or map resource argument(4) expected.");
+	if (!block && !map && !grid) {
+		error(L, "Function, map resource or grid argument(4) expected.");
 
 		return 0;
 	}
 
+	if (grid) {
+		Math::Vec2f intersectionPos;
+		Math::Vec2i intersectionIndex;
+		Real intersectionDist = 0;
+		Raycaster::Directions intersectionDir = Raycaster::INVALID;
+		const int ret = obj->get()->solve(
+			*rayPos, *rayDir,
+			grid->get(),
+			intersectionPos, intersectionIndex,
+			intersectionDist, intersectionDir
+		);
+
+		if (!ret)
+			return write(L, nullptr, nullptr);
+
+		return write(L, &intersectionPos, intersectionIndex);
+	}
+
 	Raycaster::BlockingHandler block_ = nullptr;
 	if (block) {
 		block_ = [L, block] (const Math::Vec2i &pos) -> bool {
@@ -1604,34 +2132,157 @@ static int Raycaster_solve(lua_State* L) {
 		};
 	}
 	Raycaster::EvaluationHandler eval = nullptr;
+	Map::Ptr snapshot = nullptr;
 	if (map) {
-		eval = std::bind(
-			[impl] (Resources::Map::Ptr map, const Math::Vec2i &pos) -> int {
-				int cel = -1;
-				impl->primitives()->mget(map, (int)pos.x, (int)pos.y, cel);
+		snapshot = impl->primitives()->mget(*map);
+		const Map* ptr = snapshot.get();
+		eval = [ptr] (const Math::Vec2i &pos) -> int {
+			if (!ptr)
+				return Map::INVALID();
+
+			return ptr->get((int)pos.x, (int)pos.y);
+		};
+	}
+	const Raycaster::AccessHandler access = block_ ? Raycaster::AccessHandler(block_) : Raycaster::AccessHandler(eval);
+
+	Math::Vec2f intersectionPos;
+	Math::Vec2i intersectionIndex;
+	Real intersectionDist = 0;
+	Raycaster::Directions intersectionDir = Raycaster::INVALID;
+	const int ret = obj->get()->solve(
+		*rayPos, *rayDir,
+		access,
+		intersectionPos, intersectionIndex,
+		intersectionDist, intersectionDir
+	);
+
+	if (!ret)
+		return write(L, nullptr, nullptr);
+
+	return write(L, &intersectionPos, intersectionIndex);
+}
+
+static int Raycaster_solveMany(lua_State* L) {
+	ScriptingLua* impl = ScriptingLua::instanceOf(L);
+
+	const int n = getTop(L);
+	Raycaster::Ptr* obj = nullptr;
+	Bytes::Ptr* rays = nullptr;
+	Placeholder _3;
+	Bytes::Ptr* hits = nullptr;
+	if (n >= 4)
+		read<>(L, obj, rays, _3, hits);
+	else
+		read<>(L, obj, rays, _3);
+
+	Resources::Map::Ptr* map = nullptr;
+	Grid::Ptr* grid = nullptr;
+	read<3>(L, map);
+	if (!map)
+		read<3>(L, grid);
+
+	if (!obj)
+		return 0;
+
+	if (!rays || !rays->get())
+		return 0;
+
+	if (!map && !grid) {
+		error(L, "Map resource or grid argument(3) expected.");
+
+		return 0;
+	}
+
+	const int count = (int)(rays->get()->count() / sizeof(Raycaster::Ray));
+	std::vector<Raycaster::Ray> rays_(count);
+	if (count > 0)
+		memcpy(&rays_.front(), rays->get()->pointer(), count * sizeof(Raycaster::Ray));
+	std::vector<Raycaster::Hit> hits_(count);
+
+	if (grid) {
+		if (count > 0)
+			obj->get()->solve(&rays_.front(), count, grid->get(), true, &hits_.front());
+	} else {
+		const Map::Ptr snapshot = impl->primitives()->mget(*map);
+		const Map* ptr = snapshot.get();
+		const Raycaster::EvaluationHandler eval = [ptr] (const Math::Vec2i &pos) -> int {
+			if (!ptr)
+				return Map::INVALID();
+
+			return ptr->get((int)pos.x, (int)pos.y);
+		};
+		if (count > 0)
+			obj->get()->solve(&rays_.front(), count, Raycaster::AccessHandler(eval), true, &hits_.front());
+	}
+
+	Bytes::Ptr ret = nullptr;
+	if (hits && hits->get())
+		ret = *hits;
+	else
+		ret = Bytes::Ptr(Bytes::create());
+	ret->resize(count * sizeof(Raycaster::Hit));
+	if (count > 0)
+		memcpy(ret->pointer(), &hits_.front(), count * sizeof(Raycaster::Hit));
+	ret->poke(0);
+
+	return write(L, &ret);
+}
+
+static int Raycaster_fov(lua_State* L) {
+	ScriptingLua* impl = ScriptingLua::instanceOf(L);
+
+	Raycaster::Ptr* obj = nullptr;
+	Math::Vec2i origin;
+	int radius = 0;
+	Placeholder _4;
+	Bytes::Ptr* bits = nullptr;
+	read<>(L, obj, origin, radius, _4, bits);
+
+	Resources::Map::Ptr* map = nullptr;
+	Grid::Ptr* grid = nullptr;
+	read<4>(L, map);
+	if (!map)
+		read<4>(L, grid);
+
+	if (!obj)
+		return 0;
 
-				return cel;
-			},
-			*map, std::placeholders::_1
-		);
+	if (!map && !grid) {
+		error(L, "Map resource or grid argument(4) expected.");
+
+		return 0;
 	}
-	const Raycaster::AccessHandler access = block_ ? Raycaster::AccessHandler(block_) : Raycaster::AccessHandler(eval);
 
-	Math::Vec2f intersectionPos;
-	Math::Vec2i intersectionIndex;
-	Real intersectionDist = 0;
-	Raycaster::Directions intersectionDir = Raycaster::INVALID;
-	const int ret = obj->get()->solve(
-		*rayPos, *rayDir,
-		access,
-		intersectionPos, intersectionIndex,
-		intersectionDist, intersectionDir
-	);
+	if (!bits || !bits->get()) {
+		error(L, "Bytes argument(5) expected.");
 
-	if (!ret)
-		return write(L, nullptr, nullptr);
+		return 0;
+	}
 
-	return write(L, &intersectionPos, intersectionIndex);
+	Bytes* buf = bits->get();
+	int ret = 0;
+	if (grid) {
+		const Grid* ptr = grid->get();
+		buf->resize(((size_t)ptr->width() * ptr->height() + 7) / 8);
+		if (buf->count() > 0)
+			ret = obj->get()->fov(origin, radius, ptr, buf->pointer());
+	} else {
+		const Map::Ptr snapshot = impl->primitives()->mget(*map);
+		const Map* ptr = snapshot.get();
+		if (ptr) {
+			const Raycaster::EvaluationHandler eval = [ptr] (const Math::Vec2i &pos) -> int {
+				return ptr->get((int)pos.x, (int)pos.y);
+			};
+			buf->resize(((size_t)ptr->width() * ptr->height() + 7) / 8);
+			if (buf->count() > 0)
+				ret = obj->get()->fov(origin, radius, Raycaster::AccessHandler(eval), ptr->width(), ptr->height(), buf->pointer());
+		} else {
+			buf->clear();
+		}
+	}
+	buf->poke(0);
+
+	return write(L, ret);
 }
 
 static int Raycaster___index(lua_State* L) {
@@ -1697,6 +2348,8 @@ static void open_Raycaster(lua_State* L) {
 		),
 		array(
 			luaL_Reg{ "solve", Raycaster_solve },
+			luaL_Reg{ "solveMany", Raycaster_solveMany },
+			luaL_Reg{ "fov", Raycaster_fov },
 			luaL_Reg{ nullptr, nullptr }
 		),
 		Raycaster___index, Raycaster___newindex
@@ -1731,10 +2384,13 @@ static int Walker_solve(lua_State* L) {
 
 	Function::Ptr block = nullptr;
 	Resources::Map::Ptr* map = nullptr;
+	Grid::Ptr* grid = nullptr;
 	if (isFunction(L, 4))
 		read<4>(L, block);
 	else
 		read<4>(L, map);
+	if (!block && !map)
+		read<4>(L, grid);
 
 	if (!obj)
 		return 0;
@@ -1742,12 +2398,24 @@ static int Walker_solve(lua_State* L) {
 	if (!objPos || !expDir)
 		return 0;
 
-	if (!block && !map) {
-		error(L, "Function or map resource argument(4) expected.");
+	if (!block && !map && !grid) {
+		error(L, "Function, map resource or grid argument(4) expected.");
 
 		return 0;
 	}
 
+	if (grid) {
+		Math::Vec2f newDir;
+		const int ret = obj->get()->solve(
+			*objPos, *expDir,
+			grid->get(),
+			newDir,
+			slidable
+		);
+
+		return write(L, &newDir, !!ret); // Undocumented: secondary value.
+	}
+
 	Walker::BlockingHandler block_ = nullptr;
 	if (block) {
 		block_ = [L, block] (const Math::Vec2i &pos) -> Walker::Blocking {
@@ -1758,16 +2426,16 @@ static int Walker_solve(lua_State* L) {
 		};
 	}
 	Walker::EvaluationHandler eval = nullptr;
+	Map::Ptr snapshot = nullptr;
 	if (map) {
-		eval = std::bind(
-			[impl] (Resources::Map::Ptr map, const Math::Vec2i &pos) -> int {
-				int cel = -1;
-				impl->primitives()->mget(map, (int)pos.x, (int)pos.y, cel);
+		snapshot = impl->primitives()->mget(*map);
+		const Map* ptr = snapshot.get();
+		eval = [ptr] (const Math::Vec2i &pos) -> int {
+			if (!ptr)
+				return Map::INVALID();
 
-				return cel;
-			},
-			*map, std::placeholders::_1
-		);
+			return ptr->get((int)pos.x, (int)pos.y);
+		};
 	}
 	const Walker::AccessHandler access = block_ ? Walker::AccessHandler(block_) : Walker::AccessHandler(eval);
 
@@ -1782,6 +2450,75 @@ static int Walker_solve(lua_State* L) {
 	return write(L, &newDir, !!ret); // Undocumented: secondary value.
 }
 
+static int Walker_solveMany(lua_State* L) {
+	ScriptingLua* impl = ScriptingLua::instanceOf(L);
+
+	const int n = getTop(L);
+	Walker::Ptr* obj = nullptr;
+	Bytes::Ptr* motions = nullptr;
+	Placeholder _3;
+	int slidable = 5;
+	Bytes::Ptr* newDirs = nullptr;
+	if (n >= 5)
+		read<>(L, obj, motions, _3, slidable, newDirs);
+	else if (n >= 4)
+		read<>(L, obj, motions, _3, slidable);
+	else
+		read<>(L, obj, motions, _3);
+
+	Resources::Map::Ptr* map = nullptr;
+	Grid::Ptr* grid = nullptr;
+	read<3>(L, map);
+	if (!map)
+		read<3>(L, grid);
+
+	if (!obj)
+		return 0;
+
+	if (!motions || !motions->get())
+		return 0;
+
+	if (!map && !grid) {
+		error(L, "Map resource or grid argument(3) expected.");
+
+		return 0;
+	}
+
+	const int count = (int)(motions->get()->count() / sizeof(Walker::Motion));
+	std::vector<Walker::Motion> motions_(count);
+	if (count > 0)
+		memcpy(&motions_.front(), motions->get()->pointer(), count * sizeof(Walker::Motion));
+	std::vector<Walker::Direction> newDirs_(count);
+
+	if (grid) {
+		if (count > 0)
+			obj->get()->solve(&motions_.front(), count, grid->get(), true, &newDirs_.front(), slidable);
+	} else {
+		const Map::Ptr snapshot = impl->primitives()->mget(*map);
+		const Map* ptr = snapshot.get();
+		const Walker::EvaluationHandler eval = [ptr] (const Math::Vec2i &pos) -> int {
+			if (!ptr)
+				return Map::INVALID();
+
+			return ptr->get((int)pos.x, (int)pos.y);
+		};
+		if (count > 0)
+			obj->get()->solve(&motions_.front(), count, Walker::AccessHandler(eval), true, &newDirs_.front(), slidable);
+	}
+
+	Bytes::Ptr ret = nullptr;
+	if (newDirs && newDirs->get())
+		ret = *newDirs;
+	else
+		ret = Bytes::Ptr(Bytes::create());
+	ret->resize(count * sizeof(Walker::Direction));
+	if (count > 0)
+		memcpy(ret->pointer(), &newDirs_.front(), count * sizeof(Walker::Direction));
+	ret->poke(0);
+
+	return write(L, &ret);
+}
+
 static int Walker___index(lua_State* L) {
 	Walker::Ptr* obj = nullptr;
 	const char* field = nullptr;
@@ -1854,6 +2591,7 @@ static void open_Walker(lua_State* L) {
 		),
 		array(
 			luaL_Reg{ "solve", Walker_solve },
+			luaL_Reg{ "solveMany", Walker_solveMany },
 			luaL_Reg{ nullptr, nullptr }
 		),
 		Walker___index, Walker___newindex
@@ -7469,7 +8207,7 @@ template<typename P, typename Q, typename R> static P Resources_tryWait(Executab
 	return q->pointer;
 }
 
-template<typename P, typename Q, typename R> static P Resources_waitUntilProcessed(Executable* exec, Primitives* primitives, Q &q, R r, unsigned y = P::element_type::TYPE()) {
+template<typename P, typename Q, typename R> static P Resources_waitUntilProcessed(Executable* exec, Primitives* primitives, Q &q, R r, unsigned y) {
 	if (!q->pointer) {
 		Resources::Asset::Ptr asset(new Resources::Asset(y, r));
 		asset->from(*q);
@@ -8855,6 +9593,141 @@ static void open_Font(lua_State* L) {
 	);
 }
 
+/**< Grid. */
+
+static int Grid_ctor(lua_State* L) {
+	ScriptingLua* impl = ScriptingLua::instanceOf(L);
+
+	const int n = getTop(L);
+	Resources::Map::Ptr* map = nullptr;
+	Bytes::Ptr* bytes = nullptr;
+	read<1>(L, map);
+	if (!map)
+		read<1>(L, bytes);
+
+	Grid::Ptr obj(Grid::create());
+	if (!obj)
+		return write(L, nullptr);
+
+	if (map && *map) {
+		Grid::Ranges ranges;
+		if (n >= 2 && isTable(L, 2)) {
+			const int count = (int)len(L, 2);
+			for (int i = 0; i < count; ++i) {
+				get(L, 2, i + 1); // 1-based.
+				if (isNumber(L, -1)) {
+					const int cel = (int)lua_tointeger(L, -1);
+					ranges.push_back(Grid::Range(cel, cel));
+				} else if (isTable(L, -1)) {
+					const int top = getTop(L);
+					get(L, top, 1);
+					const int first = (int)lua_tointeger(L, -1);
+					pop(L);
+					get(L, top, 2);
+					const int second = isNumber(L, -1) ? (int)lua_tointeger(L, -1) : first;
+					pop(L);
+					ranges.push_back(Grid::Range(first, second));
+				}
+				pop(L);
+			}
+		} else {
+			ranges.push_back(Grid::Range(16, std::numeric_limits<int>::max())); // The same as the evaluation with map.
+		}
+
+		Resources_waitUntilProcessed<Map::Ptr>(impl, impl->primitives(), *map, (*map)->ref);
+
+		const Map::Ptr snapshot = impl->primitives()->mget(*map);
+		if (!obj->fromMap(snapshot, ranges))
+			return write(L, nullptr);
+	} else if (bytes && bytes->get()) {
+		Placeholder _1;
+		int width = 0, height = 0;
+		read<>(L, _1, width, height);
+
+		if (!obj->fromBits(bytes->get()->pointer(), bytes->get()->count(), width, height))
+			return write(L, nullptr);
+	} else {
+		error(L, "Map resource or Bytes expected.");
+
+		return 0;
+	}
+
+	return write(L, &obj);
+}
+
+static int Grid_get(lua_State* L) {
+	Grid::Ptr* obj = nullptr;
+	Math::Vec2i pos;
+	read<>(L, obj, pos);
+
+	if (obj) {
+		const bool ret = obj->get()->get((int)pos.x, (int)pos.y);
+
+		return write(L, ret);
+	}
+
+	return 0;
+}
+
+static int Grid_set(lua_State* L) {
+	Grid::Ptr* obj = nullptr;
+	Math::Vec2i pos;
+	bool blocked = false;
+	read<>(L, obj, pos, blocked);
+
+	if (obj) {
+		const bool ret = obj->get()->set((int)pos.x, (int)pos.y, blocked);
+
+		return write(L, ret);
+	}
+
+	return 0;
+}
+
+static int Grid___index(lua_State* L) {
+	Grid::Ptr* obj = nullptr;
+	const char* field = nullptr;
+	read<>(L, obj, field);
+
+	if (!obj || !field)
+		return 0;
+
+	if (strcmp(field, "width") == 0) {
+		const int ret = obj->get()->width();
+
+		return write(L, ret);
+	} else if (strcmp(field, "height") == 0) {
+		const int ret = obj->get()->height();
+
+		return write(L, ret);
+	} else {
+		return __index(L, field);
+	}
+}
+
+static void open_Grid(lua_State* L) {
+	def(
+		L, "Grid",
+		LUA_LIB(
+			array(
+				luaL_Reg{ "new", Grid_ctor },
+				luaL_Reg{ nullptr, nullptr }
+			)
+		),
+		array(
+			luaL_Reg{ "__gc", __gc<Grid::Ptr> },
+			luaL_Reg{ "__tostring", __tostring<Grid::Ptr> },
+			luaL_Reg{ nullptr, nullptr }
+		),
+		array(
+			luaL_Reg{ "get", Grid_get },
+			luaL_Reg{ "set", Grid_set },
+			luaL_Reg{ nullptr, nullptr }
+		),
+		Grid___index, nullptr
+	);
+}
+
 /**< Primitives. */
 
 static int Primitives_cls(lua_State* L) {
@@ -9264,6 +10137,157 @@ static int Primitives_spr(lua_State* L) {
 	return 0;
 }
 
+/**
+ * @brief Counts packed instances in a flat array of numbers or `Bytes`.
+ *
+ * @note Each sprite instance is `x, y, w, h, rotAngle, rgba`, and each texture
+ *   instance is `x, y, w, h, sx, sy, sw, sh, rotAngle, rgba`. In `Bytes`, the
+ *   integers are `Int32`, the rotation angle is `Single` in radians, and the
+ *   color is `UInt32` as `Color:toRGBA()`.
+ *
+ * @return The instance count, or -1 if the source is neither.
+ */
+static int Primitives_instances(lua_State* L, int idx, bool withSource) {
+	const int fields = withSource ? 10 : 6;
+
+	if (isUserdata(L, idx)) {
+		Bytes::Ptr* bytes = nullptr;
+		read(L, bytes, Index(idx));
+		if (!bytes || !bytes->get())
+			return -1;
+
+		const size_t stride = sizeof(Int32) * (fields - 2) + sizeof(Single) + sizeof(UInt32);
+		const size_t count = bytes->get()->count() / stride;
+
+		return (int)std::min(count, (size_t)std::numeric_limits<int>::max());
+	} else if (isTable(L, idx)) {
+		const int size = (int)len(L, idx);
+
+		return size / fields;
+	}
+
+	return -1;
+}
+/**
+ * @brief Reads packed instances in place, from the source counted by
+ *   `Primitives_instances(...)`.
+ */
+static void Primitives_instances(lua_State* L, int idx, bool withSource, Primitives::Instance* instances, int count) {
+	const int fields = withSource ? 10 : 6;
+
+	if (isUserdata(L, idx)) {
+		Bytes::Ptr* bytes = nullptr;
+		read(L, bytes, Index(idx));
+
+		const Byte* ptr = bytes->get()->pointer();
+		for (int i = 0; i < count; ++i) {
+			Primitives::Instance &inst = instances[i];
+			Int32 ints[8];
+			Single rotAngle = 0;
+			UInt32 rgba = 0;
+			memcpy(ints, ptr, sizeof(Int32) * (fields - 2));
+			ptr += sizeof(Int32) * (fields - 2);
+			memcpy(&rotAngle, ptr, sizeof(Single));
+			ptr += sizeof(Single);
+			memcpy(&rgba, ptr, sizeof(UInt32));
+			ptr += sizeof(UInt32);
+
+			inst.x = ints[0];
+			inst.y = ints[1];
+			inst.width = ints[2];
+			inst.height = ints[3];
+			if (withSource) {
+				inst.sx = ints[4];
+				inst.sy = ints[5];
+				inst.swidth = ints[6];
+				inst.sheight = ints[7];
+			}
+			inst.rotAngle = (float)Math::radToDeg(rotAngle);
+			inst.color.fromRGBA(rgba);
+		}
+	} else {
+		lua_Number vals[10];
+		for (int i = 0; i < count; ++i) {
+			for (int k = 0; k < fields; ++k) {
+				get(L, idx, i * fields + k + 1); // 1-based.
+				vals[k] = lua_tonumber(L, -1);
+				pop(L);
+			}
+
+			Primitives::Instance &inst = instances[i];
+			inst.x = (int)vals[0];
+			inst.y = (int)vals[1];
+			inst.width = (int)vals[2];
+			inst.height = (int)vals[3];
+			if (withSource) {
+				inst.sx = (int)vals[4];
+				inst.sy = (int)vals[5];
+				inst.swidth = (int)vals[6];
+				inst.sheight = (int)vals[7];
+			}
+			inst.rotAngle = (float)Math::radToDeg(vals[fields - 2]);
+			inst.color.fromRGBA((UInt32)(lua_Integer)vals[fields - 1]);
+		}
+	}
+}
+
+static int Primitives_texs(lua_State* L) {
+	ScriptingLua* impl = ScriptingLua::instanceOf(L);
+
+	Resources::Texture::Ptr* res = nullptr;
+	read<>(L, res);
+
+	const int count = Primitives_instances(L, 2, true);
+	if (count < 0) {
+		error(L, "Bytes or array expected.");
+
+		return 0;
+	}
+
+	if (count > 0) {
+		impl->primitives()->texs(
+			res ? *res : nullptr, count,
+			[L] (Primitives::Instance* instances, int count) -> void {
+				Primitives_instances(L, 2, true, instances, count);
+			}
+		);
+	}
+
+	return 0;
+}
+
+static int Primitives_sprs(lua_State* L) {
+	ScriptingLua* impl = ScriptingLua::instanceOf(L);
+
+	Resources::Sprite::Ptr* res = nullptr;
+	read<>(L, res);
+
+	if (!res || !*res) {
+		error(L, "Sprite resource expected.");
+
+		return 0;
+	}
+
+	const int count = Primitives_instances(L, 2, false);
+	if (count < 0) {
+		error(L, "Bytes or array expected.");
+
+		return 0;
+	}
+
+	if (count > 0) {
+		impl->primitives()->sprs(
+			*res, count,
+			[L] (Primitives::Instance* instances, int count) -> void {
+				Primitives_instances(L, 2, false, instances, count);
+			},
+			impl->delta()
+		);
+	}
+
+	return 0;
+}
+
 static int Primitives_map(lua_State* L) {
 	ScriptingLua* impl = ScriptingLua::instanceOf(L);
 
@@ -9295,7 +10319,8 @@ static int Primitives_pget(lua_State* L) {
 	read<>(L, res, index);
 
 	if (res && *res) {
-		Resources_waitUntilProcessed<Palette::Ptr>(impl, impl->primitives(), *res, nullptr);
+		if (!(*res)->shadow) // Loaded already if it has a snapshot.
+			Resources_waitUntilProcessed<Palette::Ptr>(impl, impl->primitives(), *res, nullptr);
 
 		Color col;
 		impl->primitives()->pget(*res, index, col);
@@ -9335,7 +10360,8 @@ static int Primitives_mget(lua_State* L) {
 	read<>(L, res, x, y);
 
 	if (res && *res) {
-		Resources_waitUntilProcessed<Map::Ptr>(impl, impl->primitives(), *res, (*res)->ref);
+		if (!(*res)->shadow) // Loaded already if it has a snapshot.
+			Resources_waitUntilProcessed<Map::Ptr>(impl, impl->primitives(), *res, (*res)->ref);
 
 		int cel = Map::INVALID();
 		impl->primitives()->mget(*res, x, y, cel);
@@ -9348,20 +10374,101 @@ static int Primitives_mget(lua_State* L) {
 	return 0;
 }
 
+static bool Primitives_integers(lua_State* L, int idx, std::vector<int> &ints) {
+	ints.clear();
+
+	if (isUserdata(L, idx)) {
+		Bytes::Ptr* bytes = nullptr;
+		read(L, bytes, Index(idx));
+		if (!bytes || !bytes->get())
+			return false;
+
+		const size_t count = bytes->get()->count() / sizeof(Int32);
+		ints.resize(count);
+		const Byte* ptr = bytes->get()->pointer();
+		for (size_t i = 0; i < count; ++i) {
+			Int32 val = 0;
+			memcpy(&val, ptr + i * sizeof(Int32), sizeof(Int32));
+			ints[i] = (int)val;
+		}
+
+		return true;
+	} else if (isTable(L, idx)) {
+		const int count = (int)len(L, idx);
+		ints.resize(count);
+		for (int i = 0; i < count; ++i) {
+			get(L, idx, i + 1); // 1-based.
+			ints[i] = (int)lua_tointeger(L, -1);
+			pop(L);
+		}
+
+		return true;
+	}
+
+	return false;
+}
+
 static int Primitives_mset(lua_State* L) {
 	ScriptingLua* impl = ScriptingLua::instanceOf(L);
 
+	const int n = getTop(L);
 	Resources::Map::Ptr* res = nullptr;
-	int x = -1, y = -1;
-	int cel = Map::INVALID();
-	read<>(L, res, x, y, cel);
+	if (n >= 6) {
+		int x = -1, y = -1, w = 0, h = 0;
+		read<>(L, res, x, y, w, h);
 
-	if (res && *res) {
-		Resources_waitUntilProcessed<Map::Ptr>(impl, impl->primitives(), *res, (*res)->ref);
+		if (res && *res) {
+			Resources_waitUntilProcessed<Map::Ptr>(impl, impl->primitives(), *res, (*res)->ref);
+
+			if (isNumber(L, 6)) {
+				int cel = Map::INVALID();
+				read<6>(L, cel);
+
+				impl->primitives()->mset(*res, x, y, w, h, cel);
+			} else {
+				std::vector<int> cels;
+				if (!Primitives_integers(L, 6, cels) || w <= 0 || h <= 0 || (size_t)w > cels.size() / (size_t)h) {
+					error(L, "Cels expected.");
+
+					return 0;
+				}
+
+				impl->primitives()->mset(*res, x, y, w, h, &cels.front());
+			}
+		} else {
+			error(L, "Map resource expected.");
+		}
+	} else if (n == 2) {
+		read<>(L, res);
+
+		if (res && *res) {
+			std::vector<int> edits;
+			if (!Primitives_integers(L, 2, edits)) {
+				error(L, "Edits expected.");
+
+				return 0;
+			}
 
-		impl->primitives()->mset(*res, x, y, cel);
+			Resources_waitUntilProcessed<Map::Ptr>(impl, impl->primitives(), *res, (*res)->ref);
+
+			const int count = (int)edits.size() / 3;
+			if (count > 0)
+				impl->primitives()->mset(*res, &edits.front(), count);
+		} else {
+			error(L, "Map resource expected.");
+		}
 	} else {
-		error(L, "Map resource expected.");
+		int x = -1, y = -1;
+		int cel = Map::INVALID();
+		read<>(L, res, x, y, cel);
+
+		if (res && *res) {
+			Resources_waitUntilProcessed<Map::Ptr>(impl, impl->primitives(), *res, (*res)->ref);
+
+			impl->primitives()->mset(*res, x, y, cel);
+		} else {
+			error(L, "Map resource expected.");
+		}
 	}
 
 	return 0;
@@ -9688,11 +10795,13 @@ static void open_Primitives(lua_State* L) {
 			luaL_Reg{ "tri", Primitives_tri },
 			luaL_Reg{ "tex", Primitives_tex },
 			luaL_Reg{ "spr", Primitives_spr },
+			luaL_Reg{ "texs", Primitives_texs },
+			luaL_Reg{ "sprs", Primitives_sprs },
 			luaL_Reg{ "map", Primitives_map },
 			luaL_Reg{ "pget", Primitives_pget }, // Resources synchronized.
 			luaL_Reg{ "pset", Primitives_pset }, // Resources/frame synchronized.
 			luaL_Reg{ "mget", Primitives_mget }, // Resources synchronized.
-			luaL_Reg{ "mset", Primitives_mset }, // Resources/frame synchronized.
+			luaL_Reg{ "mset", Primitives_mset }, // Resources synchronized.
 			luaL_Reg{ "volume", Primitives_volume }, // Frame synchronized.
 			luaL_Reg{ "play", Primitives_play }, // Frame synchronized.
 			luaL_Reg{ "stop", Primitives_stop }, // Frame synchronized.
@@ -9728,6 +10837,9 @@ void open(class Executable* exec) {
 	// Font.
 	open_Font(L);
 
+	// Grid.
+	open_Grid(L);
+
 	// Primitives.
 	open_Primitives(L);
 }
@@ -8,6 +8,8 @@
 ** For the latest info, see https://github.com/paladin-t/bitty/
 */
 
+#include "bytes.h"
+#include "primitives.h"
 #include "scripting_lua.h"
 #include "scripting_lua_api_physics.h"
 #include "../lib/chipmunk2d/include/chipmunk/chipmunk.h"
@@ -15,6 +17,7 @@
 extern "C" {
 #endif
 #	include "../lib/chipmunk2d/include/chipmunk/chipmunk_structs.h"
+#	include "../lib/chipmunk2d/include/chipmunk/cpHastySpace.h"
 #ifdef __cplusplus
 }
 #endif
@@ -34,6 +37,18 @@ extern "C" {
 		const TYPE::WeakPtr WEAK = SHARED;
 #endif /* LUA_WEAK_PTR */
 
+#ifndef PHYSICS_COLLISION_EVENT_MAX_COUNT
+#	define PHYSICS_COLLISION_EVENT_MAX_COUNT 65536
+#endif /* PHYSICS_COLLISION_EVENT_MAX_COUNT */
+
+#ifndef PHYSICS_DEBUG_DRAW_MAX_SEGMENTS
+#	define PHYSICS_DEBUG_DRAW_MAX_SEGMENTS 32
+#endif /* PHYSICS_DEBUG_DRAW_MAX_SEGMENTS */
+
+#ifndef PHYSICS_QUERY_PARALLEL_MIN_COUNT
+#	define PHYSICS_QUERY_PARALLEL_MIN_COUNT 64
+#endif /* PHYSICS_QUERY_PARALLEL_MIN_COUNT */
+
 /* ===========================================================================} */
 
 /*
@@ -62,6 +77,24 @@ LUA_WRITE_ALIAS_CONST(Math::Rotf, Rot)
 
 }
 
+namespace Lua { // Library.
+
+/**< Bytes. */
+
+LUA_CHECK_OBJ(Bytes)
+LUA_READ_OBJ(Bytes)
+LUA_WRITE_OBJ(Bytes)
+LUA_WRITE_OBJ_CONST(Bytes)
+
+/**< Color. */
+
+LUA_CHECK(Color)
+LUA_READ(Color)
+LUA_WRITE(Color)
+LUA_WRITE_CONST(Color)
+
+}
+
 namespace Lua { // Engine.
 
 /**< Vertex. */
@@ -698,6 +731,15 @@ struct BodyData : public ReferencableData<Body::Ptr, Body::WeakPtr>, public Mana
 	Function::Ptr velocityHandler = nullptr;
 	Function::Ptr positionHandler = nullptr;
 
+	/**
+	 * @brief The pose before the latest fixed step, valid while `captured`
+	 *   matches the capturing generation of the space in `capturer`.
+	 */
+	cpVect previousPosition = cpVect{ 0, 0 };
+	cpFloat previousAngle = 0;
+	const void* capturer = nullptr;
+	UInt64 captured = 0;
+
 	BodyData(Body::Ptr &self_, lua_State* L_) : ReferencableData(self_), L(L_) {
 	}
 	~BodyData() {
@@ -792,8 +834,32 @@ struct SpaceData : public ReferencableData<Space::Ptr, Space::WeakPtr> {
 		}
 	};
 	typedef std::map<CollisionKey, CollisionHandler> CollisionHandlerDictionary;
+	enum CollisionPhases : unsigned {
+		COLLISION_BEGAN = 1 << 0,
+		COLLISION_PERSISTED = 1 << 1,
+		COLLISION_SEPARATED = 1 << 2
+	};
+	/**
+	 * @brief Packed collision event in 64 bytes.
+	 */
+	struct CollisionEvent {
+		UInt64 shapeA = 0;
+		UInt64 shapeB = 0;
+		UInt64 typeA = 0;
+		UInt64 typeB = 0;
+		Int32 phase = 0;
+		Int32 count = 0;
+		Single normal[2] = { 0, 0 };
+		Single point[2] = { 0, 0 };
+		Single impulse[2] = { 0, 0 };
+	};
+	typedef std::vector<CollisionEvent> CollisionEventArray;
+	typedef std::pair<const cpShape*, const cpShape*> CollisionPair;
+	typedef std::map<CollisionPair, CollisionEvent> CollisionContactDictionary;
 
 	lua_State* L = nullptr;
+	bool hasty = false;
+	bool spatialHash = false; // Spatial hash queries are not reentrant.
 	bool quitting = false;
 	bool calling = false;
 	bool querying = false;
@@ -811,11 +877,134 @@ struct SpaceData : public ReferencableData<Space::Ptr, Space::WeakPtr> {
 	CollisionHandlerDictionary wildcardHandlers;
 	CollisionKey key;
 
+	unsigned bufferedPhases = 0;
+	CollisionEventArray collisionEvents;
+	CollisionContactDictionary collisionContacts;
+
+	cpFloat fixedAccumulator = 0;
+	cpFloat fixedAlpha = 1;
+	UInt64 captured = 0; // Generation of the latest pose capturing.
+
 	SpaceData(Space::Ptr &self_, lua_State* L_) : ReferencableData(self_), L(L_) {
 	}
 	~SpaceData() {
 	}
 
+	/**
+	 * @brief Records the collision events by scanning the active arbiters
+	 *   after a step; separations are detected by comparing with the contacts
+	 *   of the previous step.
+	 */
+	void buffer(cpSpace* space) {
+		auto push = [this] (const CollisionEvent &evt) -> void {
+			if (!(bufferedPhases & (unsigned)evt.phase))
+				return;
+			if (collisionEvents.size() >= PHYSICS_COLLISION_EVENT_MAX_COUNT)
+				return;
+
+			collisionEvents.push_back(evt);
+		};
+
+		CollisionContactDictionary contacts;
+		const cpArray* arbiters = space->arbiters;
+		for (int i = 0; i < arbiters->num; ++i) {
+			const cpArbiter* arbiter = (const cpArbiter*)arbiters->arr[i];
+			cpShape* shapeA = nullptr;
+			cpShape* shapeB = nullptr;
+			cpArbiterGetShapes(arbiter, &shapeA, &shapeB);
+			const CollisionPair pair = shapeA < shapeB ? CollisionPair(shapeA, shapeB) : CollisionPair(shapeB, shapeA);
+
+			CollisionEvent evt;
+			evt.shapeA = (UInt64)(uintptr_t)shapeA;
+			evt.shapeB = (UInt64)(uintptr_t)shapeB;
+			evt.typeA = (UInt64)cpShapeGetCollisionType(shapeA);
+			evt.typeB = (UInt64)cpShapeGetCollisionType(shapeB);
+			evt.phase = (Int32)(collisionContacts.find(pair) == collisionContacts.end() || cpArbiterIsFirstContact(arbiter) ? COLLISION_BEGAN : COLLISION_PERSISTED);
+			evt.count = (Int32)cpArbiterGetCount(arbiter);
+			const cpVect normal = cpArbiterGetNormal(arbiter);
+			evt.normal[0] = (Single)normal.x;
+			evt.normal[1] = (Single)normal.y;
+			if (evt.count > 0) {
+				const cpVect point = cpArbiterGetPointA(arbiter, 0);
+				evt.point[0] = (Single)point.x;
+				evt.point[1] = (Single)point.y;
+			}
+			const cpVect impulse = cpArbiterTotalImpulse(arbiter);
+			evt.impulse[0] = (Single)impulse.x;
+			evt.impulse[1] = (Single)impulse.y;
+
+			contacts[pair] = evt;
+			push(evt);
+		}
+
+		for (CollisionContactDictionary::value_type &kv : collisionContacts) {
+			if (contacts.find(kv.first) != contacts.end())
+				continue;
+
+			// Sleeping contacts are not separated, including a sleeping body
+			// resting on a static or kinematic one, which never sleeps; never
+			// dereferences a shape before it's verified to be still in the
+			// space.
+			const cpShape* shapeA = kv.first.first;
+			const cpShape* shapeB = kv.first.second;
+			const bool aliveA = shapeCache.find(shapeA) && cpShapeGetSpace(shapeA) == space;
+			const bool aliveB = shapeCache.find(shapeB) && cpShapeGetSpace(shapeB) == space;
+			if (aliveA && aliveB && resting(cpShapeGetBody(shapeA), cpShapeGetBody(shapeB))) {
+				contacts.insert(kv);
+
+				continue;
+			}
+
+			CollisionEvent evt = kv.second;
+			evt.phase = (Int32)COLLISION_SEPARATED;
+			evt.count = 0;
+			evt.impulse[0] = evt.impulse[1] = 0;
+			push(evt);
+		}
+
+		std::swap(collisionContacts, contacts);
+	}
+	/**
+	 * @brief Gets whether a contact pair is put to sleep, that is one body is
+	 *   sleeping and the other is either sleeping or not dynamic.
+	 */
+	static bool resting(cpBody* bodyA, cpBody* bodyB) {
+		const bool sleepingA = !!cpBodyIsSleeping(bodyA);
+		const bool sleepingB = !!cpBodyIsSleeping(bodyB);
+		if (sleepingA && sleepingB)
+			return true;
+		if (sleepingA)
+			return cpBodyGetType(bodyB) != CP_BODY_TYPE_DYNAMIC;
+		if (sleepingB)
+			return cpBodyGetType(bodyA) != CP_BODY_TYPE_DYNAMIC;
+
+		return false;
+	}
+
+	/**
+	 * @brief Keeps the poses of all bodies before a fixed step in their own
+	 *   data, for interpolating between the previous and current poses;
+	 *   poses of bodies no longer in the space expire with the generation.
+	 */
+	void capture(cpSpace* space) {
+		++captured;
+		cpSpaceEachBody(
+			space,
+			[] (cpBody* body, void* data) -> void {
+				const SpaceData* spaceData = (const SpaceData*)data;
+				BodyData* bodyData = BodyData::get(body);
+				if (!bodyData)
+					return;
+
+				bodyData->previousPosition = cpBodyGetPosition(body);
+				bodyData->previousAngle = cpBodyGetAngle(body);
+				bodyData->capturer = spaceData;
+				bodyData->captured = spaceData->captured;
+			},
+			this
+		);
+	}
+
 	static Space::Ptr ref(const cpSpace* space);
 	static SpaceData* get(const cpSpace* space) {
 		if (!space)
@@ -1311,6 +1500,698 @@ Space::Ptr SpaceData::ref(const cpSpace* space) {
 	return nullptr;
 }
 
+/**< Body states. */
+
+/**
+ * @brief Packed body states for bulk exporting and importing; each record
+ *   consists of the fields specified by flags in the order of the flag bits,
+ *   ID as 64-bit unsigned integer, others in single precision reals.
+ */
+struct BodyStates {
+	typedef std::vector<cpBody*> Array;
+
+	enum Fields : unsigned {
+		ID = 1 << 0,
+		POSITION = 1 << 1,
+		ANGLE = 1 << 2,
+		VELOCITY = 1 << 3,
+		ANGULAR_VELOCITY = 1 << 4,
+		INTERPOLATED = 1 << 5
+	};
+
+	struct Record {
+		UInt64 id = 0;
+		cpVect position = cpVect{ 0, 0 };
+		cpFloat angle = 0;
+		cpVect velocity = cpVect{ 0, 0 };
+		cpFloat angularVelocity = 0;
+	};
+
+	static size_t size(unsigned fields) {
+		size_t result = 0;
+		if (fields & ID)
+			result += sizeof(UInt64);
+		if (fields & POSITION)
+			result += sizeof(Single) * 2;
+		if (fields & ANGLE)
+			result += sizeof(Single);
+		if (fields & VELOCITY)
+			result += sizeof(Single) * 2;
+		if (fields & ANGULAR_VELOCITY)
+			result += sizeof(Single);
+
+		return result;
+	}
+
+	static Byte* pack(Byte* ptr, const Record &rec, unsigned fields) {
+		auto real = [&ptr] (cpFloat val) -> void {
+			const Single val_ = (Single)val;
+			memcpy(ptr, &val_, sizeof(Single));
+			ptr += sizeof(Single);
+		};
+
+		if (fields & ID) {
+			memcpy(ptr, &rec.id, sizeof(UInt64));
+			ptr += sizeof(UInt64);
+		}
+		if (fields & POSITION) {
+			real(rec.position.x);
+			real(rec.position.y);
+		}
+		if (fields & ANGLE)
+			real(rec.angle);
+		if (fields & VELOCITY) {
+			real(rec.velocity.x);
+			real(rec.velocity.y);
+		}
+		if (fields & ANGULAR_VELOCITY)
+			real(rec.angularVelocity);
+
+		return ptr;
+	}
+	static const Byte* unpack(const Byte* ptr, Record &rec, unsigned fields) {
+		auto real = [&ptr] (void) -> cpFloat {
+			Single val = 0;
+			memcpy(&val, ptr, sizeof(Single));
+			ptr += sizeof(Single);
+
+			return (cpFloat)val;
+		};
+
+		if (fields & ID) {
+			memcpy(&rec.id, ptr, sizeof(UInt64));
+			ptr += sizeof(UInt64);
+		}
+		if (fields & POSITION) {
+			rec.position.x = real();
+			rec.position.y = real();
+		}
+		if (fields & ANGLE)
+			rec.angle = real();
+		if (fields & VELOCITY) {
+			rec.velocity.x = real();
+			rec.velocity.y = real();
+		}
+		if (fields & ANGULAR_VELOCITY)
+			rec.angularVelocity = real();
+
+		return ptr;
+	}
+
+	static Record of(const cpBody* body) {
+		Record result;
+		result.id = (UInt64)(uintptr_t)body;
+		result.position = cpBodyGetPosition(body);
+		result.angle = cpBodyGetAngle(body);
+		result.velocity = cpBodyGetVelocity(body);
+		result.angularVelocity = cpBodyGetAngularVelocity(body);
+
+		return result;
+	}
+	/**
+	 * @brief Gets the state with position and angle interpolated between the
+	 *   poses before and after the latest fixed step.
+	 */
+	static Record of(const cpBody* body, const SpaceData* spaceData) {
+		Record result = of(body);
+		const BodyData* bodyData = BodyData::get(body);
+		if (!bodyData || bodyData->capturer != spaceData || bodyData->captured != spaceData->captured)
+			return result;
+
+		const cpFloat alpha = spaceData->fixedAlpha;
+		result.position = cpvlerp(bodyData->previousPosition, result.position, alpha);
+		result.angle = bodyData->previousAngle + (result.angle - bodyData->previousAngle) * alpha;
+
+		return result;
+	}
+
+	/**
+	 * @brief Collects the bodies in a list at the specific index, or all the
+	 *   bodies in the space if there's no list.
+	 */
+	static void collect(lua_State* L, int idx, cpSpace* space, Array &bodies) {
+		bodies.clear();
+
+		if (isTable(L, idx)) {
+			const int count = (int)len(L, idx);
+			bodies.reserve(count);
+			for (int i = 0; i < count; ++i) {
+				get(L, idx, i + 1); // 1-based.
+				Body::Ptr* body = nullptr;
+				read(L, body, Index(-1));
+				pop(L);
+
+				bodies.push_back(body ? body->get() : nullptr);
+			}
+		} else {
+			cpSpaceEachBody(
+				space,
+				[] (cpBody* body, void* data) -> void {
+					Array* bodies = (Array*)data;
+					bodies->push_back(body);
+				},
+				&bodies
+			);
+		}
+	}
+	/**
+	 * @brief Finds a body in the space by its ID; never dereferences the ID
+	 *   before it's verified to be a body in the space.
+	 */
+	static cpBody* find(cpSpace* space, UInt64 id) {
+		SpaceData* spaceData = SpaceData::get(space);
+		cpBody* body = (cpBody*)(uintptr_t)id;
+		if (!spaceData->bodyCache.find(body))
+			return nullptr;
+		if (cpBodyGetSpace(body) != space)
+			return nullptr;
+
+		return body;
+	}
+};
+
+/**< Debug drawer. */
+
+/**
+ * @brief Collects the geometry emitted by `cpSpaceDebugDraw` into triangles and
+ *   line segments, which are submitted as a single primitive command.
+ */
+struct DebugDrawer {
+	typedef std::vector<Primitives::Vertex> Vertices;
+
+	enum Flags : unsigned {
+		SHAPES = CP_SPACE_DEBUG_DRAW_SHAPES,
+		CONSTRAINTS = CP_SPACE_DEBUG_DRAW_CONSTRAINTS,
+		COLLISION_POINTS = CP_SPACE_DEBUG_DRAW_COLLISION_POINTS
+	};
+
+	Vertices triangles;
+	Vertices lines;
+	Color fillColor = Color(81, 118, 166, 128);
+
+	void draw(cpSpace* space, unsigned flags, const Color &outlineColor, const Color &constraintColor, const Color &collisionPointColor, const Primitives* primitives) {
+		cpSpaceDebugDrawOptions options;
+		options.drawCircle = drawCircle;
+		options.drawSegment = drawSegment;
+		options.drawFatSegment = drawFatSegment;
+		options.drawPolygon = drawPolygon;
+		options.drawDot = drawDot;
+		options.flags = (cpSpaceDebugDrawFlags)(flags & (SHAPES | CONSTRAINTS | COLLISION_POINTS));
+		options.shapeOutlineColor = fromColor(outlineColor);
+		options.colorForShape = colorForShape;
+		options.constraintColor = fromColor(constraintColor);
+		options.collisionPointColor = fromColor(collisionPointColor);
+		options.data = this;
+
+		triangles.clear();
+		lines.clear();
+		cpSpaceDebugDraw(space, &options);
+
+		primitives->geometry(
+			triangles.empty() ? nullptr : &triangles.front(), (int)triangles.size() / 3,
+			lines.empty() ? nullptr : &lines.front(), (int)lines.size() / 2
+		);
+	}
+
+private:
+	void triangle(cpVect a, cpVect b, cpVect c, const Color &col) {
+		if (col.a == 0)
+			return;
+
+		triangles.push_back(Primitives::Vertex((float)a.x, (float)a.y, col));
+		triangles.push_back(Primitives::Vertex((float)b.x, (float)b.y, col));
+		triangles.push_back(Primitives::Vertex((float)c.x, (float)c.y, col));
+	}
+	void line(cpVect a, cpVect b, const Color &col) {
+		if (col.a == 0)
+			return;
+
+		lines.push_back(Primitives::Vertex((float)a.x, (float)a.y, col));
+		lines.push_back(Primitives::Vertex((float)b.x, (float)b.y, col));
+	}
+	void arc(cpVect ctr, cpFloat radius, cpFloat begin, cpFloat end, const Color &outline, const Color &fill) {
+		const int segs = Math::clamp((int)(radius * (end - begin) / 4), 4, PHYSICS_DEBUG_DRAW_MAX_SEGMENTS);
+		const cpFloat step = (end - begin) / segs;
+		cpVect prev = cpvadd(ctr, cpvmult(cpvforangle(begin), radius));
+		for (int i = 1; i <= segs; ++i) {
+			const cpVect next = cpvadd(ctr, cpvmult(cpvforangle(begin + step * i), radius));
+			triangle(ctr, prev, next, fill);
+			line(prev, next, outline);
+			prev = next;
+		}
+	}
+
+	static Color toColor(const cpSpaceDebugColor &col) {
+		return Color(
+			(Byte)Math::clamp(col.r * 255.0f + 0.5f, 0.0f, 255.0f),
+			(Byte)Math::clamp(col.g * 255.0f + 0.5f, 0.0f, 255.0f),
+			(Byte)Math::clamp(col.b * 255.0f + 0.5f, 0.0f, 255.0f),
+			(Byte)Math::clamp(col.a * 255.0f + 0.5f, 0.0f, 255.0f)
+		);
+	}
+	static cpSpaceDebugColor fromColor(const Color &col) {
+		return cpSpaceDebugColor{ col.r / 255.0f, col.g / 255.0f, col.b / 255.0f, col.a / 255.0f };
+	}
+
+	static void drawCircle(cpVect pos, cpFloat angle, cpFloat radius, cpSpaceDebugColor outlineColor, cpSpaceDebugColor fillColor, cpDataPointer data) {
+		DebugDrawer* self = (DebugDrawer*)data;
+		const Color outline = toColor(outlineColor);
+		self->arc(pos, radius, 0, 2 * CP_PI, outline, toColor(fillColor));
+		self->line(pos, cpvadd(pos, cpvmult(cpvforangle(angle), radius)), outline);
+	}
+	static void drawSegment(cpVect a, cpVect b, cpSpaceDebugColor color, cpDataPointer data) {
+		DebugDrawer* self = (DebugDrawer*)data;
+		self->line(a, b, toColor(color));
+	}
+	static void drawFatSegment(cpVect a, cpVect b, cpFloat radius, cpSpaceDebugColor outlineColor, cpSpaceDebugColor fillColor, cpDataPointer data) {
+		DebugDrawer* self = (DebugDrawer*)data;
+		const Color outline = toColor(outlineColor);
+		if (radius < 1 || cpveql(a, b)) {
+			self->line(a, b, outline);
+
+			return;
+		}
+
+		const Color fill = toColor(fillColor);
+		const cpVect n = cpvmult(cpvperp(cpvnormalize(cpvsub(b, a))), radius);
+		const cpFloat angle = cpvtoangle(n);
+		self->triangle(cpvadd(a, n), cpvadd(b, n), cpvsub(b, n), fill);
+		self->triangle(cpvadd(a, n), cpvsub(b, n), cpvsub(a, n), fill);
+		self->line(cpvadd(a, n), cpvadd(b, n), outline);
+		self->line(cpvsub(a, n), cpvsub(b, n), outline);
+		self->arc(a, radius, angle, angle + CP_PI, outline, fill);
+		self->arc(b, radius, angle + CP_PI, angle + 2 * CP_PI, outline, fill);
+	}
+	static void drawPolygon(int count, const cpVect* verts, cpFloat /* radius */, cpSpaceDebugColor outlineColor, cpSpaceDebugColor fillColor, cpDataPointer data) {
+		DebugDrawer* self = (DebugDrawer*)data;
+		const Color outline = toColor(outlineColor);
+		const Color fill = toColor(fillColor);
+		for (int i = 2; i < count; ++i)
+			self->triangle(verts[0], verts[i - 1], verts[i], fill);
+		for (int i = 0; i < count; ++i)
+			self->line(verts[i], verts[(i + 1) % count], outline);
+	}
+	static void drawDot(cpFloat size, cpVect pos, cpSpaceDebugColor color, cpDataPointer data) {
+		DebugDrawer* self = (DebugDrawer*)data;
+		const Color col = toColor(color);
+		const cpFloat h = size * 0.5f;
+		self->triangle(cpv(pos.x - h, pos.y - h), cpv(pos.x + h, pos.y - h), cpv(pos.x + h, pos.y + h), col);
+		self->triangle(cpv(pos.x - h, pos.y - h), cpv(pos.x + h, pos.y + h), cpv(pos.x - h, pos.y + h), col);
+	}
+	static cpSpaceDebugColor colorForShape(cpShape* shape, cpDataPointer data) {
+		DebugDrawer* self = (DebugDrawer*)data;
+		Color col = self->fillColor;
+		cpBody* body = cpShapeGetBody(shape);
+		if (cpShapeGetSensor(shape)) {
+			col.a /= 2;
+		} else if (body && cpBodyIsSleeping(body)) {
+			const Byte g = (Byte)(((int)col.r + col.g + col.b) / 3);
+			col = Color(g, g, g, col.a);
+		} else if (body && cpBodyGetType(body) == CP_BODY_TYPE_STATIC) {
+			col = Color(col.r / 2, col.g / 2, col.b / 2, col.a);
+		}
+
+		return fromColor(col);
+	}
+};
+
+/**< Batch queries. */
+
+/**
+ * @brief Answers packed queries in bulk without creating any Lua object; the
+ *   queries are spread across threads when the space is indexed by bounding
+ *   box trees, which are read-only to query.
+ */
+struct BatchQueries {
+	struct Segment {
+		Single x0 = 0, y0 = 0, x1 = 0, y1 = 0;
+		Single radius = 0;
+	};
+	struct Point {
+		Single x = 0, y = 0;
+		Single maxDistance = 0;
+	};
+	struct Box {
+		Single left = 0, bottom = 0, right = 0, top = 0;
+	};
+	struct Hit {
+		UInt64 shape = 0; // 0 for missing.
+		Int32 index = 0; // Index of the query.
+		Single x = 0, y = 0; // Point.
+		Single nx = 0, ny = 0; // Normal, or gradient for point queries.
+		Single alpha = 0; // Alpha for segment queries, distance for point queries.
+	};
+	static_assert(sizeof(Hit) == 32, "Wrong size.");
+
+	typedef std::vector<Hit> Array;
+
+	/**
+	 * @brief Gets the chunk count to answer the specific count of queries.
+	 */
+	static int chunks(cpSpace* space, int count, bool parallel) {
+		if (SpaceData::get(space)->spatialHash)
+			return 1;
+
+		return Parallel::chunks(count, PHYSICS_QUERY_PARALLEL_MIN_COUNT, parallel);
+	}
+
+	/**
+	 * @brief Finds the first shape hit by each segment, one record per query.
+	 *
+	 * @return The count of queries that hit.
+	 */
+	static int segmentFirst(cpSpace* space, const Segment* queries, int count, const cpShapeFilter &filter, bool parallel, Array &hits) {
+		hits.assign(count, Hit());
+		std::vector<int> results(chunks(space, count, parallel), 0);
+		Parallel::fork(
+			count, (int)results.size(),
+			[&] (int chunk, int begin, int end) -> void {
+				for (int i = begin; i < end; ++i) {
+					const Segment &q = queries[i];
+					Hit &hit = hits[i];
+					hit.index = (Int32)i;
+					cpSegmentQueryInfo info;
+					cpShape* shape = cpSpaceSegmentQueryFirst(space, cpv(q.x0, q.y0), cpv(q.x1, q.y1), q.radius, filter, &info);
+					hit.shape = (UInt64)(uintptr_t)shape;
+					hit.x = (Single)info.point.x;
+					hit.y = (Single)info.point.y;
+					hit.nx = (Single)info.normal.x;
+					hit.ny = (Single)info.normal.y;
+					hit.alpha = (Single)info.alpha;
+					if (shape)
+						++results[chunk];
+				}
+			}
+		);
+
+		int result = 0;
+		for (int r : results)
+			result += r;
+
+		return result;
+	}
+	/**
+	 * @brief Finds the nearest shape to each point, one record per query.
+	 *
+	 * @return The count of queries that hit.
+	 */
+	static int pointNearest(cpSpace* space, const Point* queries, int count, const cpShapeFilter &filter, bool parallel, Array &hits) {
+		hits.assign(count, Hit());
+		std::vector<int> results(chunks(space, count, parallel), 0);
+		Parallel::fork(
+			count, (int)results.size(),
+			[&] (int chunk, int begin, int end) -> void {
+				for (int i = begin; i < end; ++i) {
+					const Point &q = queries[i];
+					Hit &hit = hits[i];
+					hit.index = (Int32)i;
+					cpPointQueryInfo info;
+					cpShape* shape = cpSpacePointQueryNearest(space, cpv(q.x, q.y), q.maxDistance, filter, &info);
+					hit.shape = (UInt64)(uintptr_t)shape;
+					hit.x = (Single)info.point.x;
+					hit.y = (Single)info.point.y;
+					hit.nx = (Single)info.gradient.x;
+					hit.ny = (Single)info.gradient.y;
+					hit.alpha = (Single)info.distance;
+					if (shape)
+						++results[chunk];
+				}
+			}
+		);
+
+		int result = 0;
+		for (int r : results)
+			result += r;
+
+		return result;
+	}
+	/**
+	 * @brief Finds all the shapes overlapping each bounding box, one record per
+	 *   shape, ordered by query.
+	 *
+	 * @return The count of records.
+	 */
+	static int boundingBox(cpSpace* space, const Box* queries, int count, const cpShapeFilter &filter, bool parallel, Array &hits) {
+		struct Context {
+			cpBB bb;
+			cpShapeFilter filter;
+			Int32 index = 0;
+			Array* hits = nullptr;
+		};
+		auto callback = [] (void* obj, void* shape_, cpCollisionID id, void* /* data */) -> cpCollisionID {
+			const Context* ctx = (const Context*)obj;
+			const cpShape* shape = (const cpShape*)shape_;
+			if (rejected(shape->filter, ctx->filter))
+				return id;
+			if (!cpBBIntersects(ctx->bb, shape->bb))
+				return id;
+
+			Hit hit;
+			hit.shape = (UInt64)(uintptr_t)shape;
+			hit.index = ctx->index;
+			ctx->hits->push_back(hit);
+
+			return id;
+		};
+
+		std::vector<Array> results(chunks(space, count, parallel));
+		Parallel::fork(
+			count, (int)results.size(),
+			[&] (int chunk, int begin, int end) -> void {
+				Context ctx;
+				ctx.filter = filter;
+				ctx.hits = &results[chunk];
+				for (int i = begin; i < end; ++i) {
+					const Box &q = queries[i];
+					ctx.bb = cpBBNew(q.left, q.bottom, q.right, q.top);
+					ctx.index = (Int32)i;
+					cpSpatialIndexQuery(space->dynamicShapes, &ctx, ctx.bb, callback, nullptr);
+					cpSpatialIndexQuery(space->staticShapes, &ctx, ctx.bb, callback, nullptr);
+				}
+			}
+		);
+
+		hits.clear();
+		for (const Array &r : results)
+			hits.insert(hits.end(), r.begin(), r.end());
+
+		return (int)hits.size();
+	}
+
+private:
+	static bool rejected(const cpShapeFilter &a, const cpShapeFilter &b) {
+		return
+			(a.group != 0 && a.group == b.group) ||
+			(a.categories & b.mask) == 0 ||
+			(b.categories & a.mask) == 0;
+	}
+};
+
+/**< Snapshot. */
+
+/**
+ * @brief Compact binary snapshot of the dynamic states of a space, for
+ *   saving and restoring many times per frame; it consists of a header with
+ *   body count and constraint count as 32-bit unsigned integers, followed by
+ *   the body records and the constraint records.
+ *
+ * @note The snapshot doesn't contain the objects themselves, adding or
+ *   removing objects is not undone by restoring, and the records of the
+ *   objects which are no longer in the space are skipped. Contact caches are
+ *   not included either.
+ */
+struct Snapshot {
+	struct Header {
+		UInt32 bodyCount = 0;
+		UInt32 constraintCount = 0;
+	};
+	struct BodyRecord {
+		UInt64 id = 0;
+		UInt64 group = 0; // ID of the sleeping component root, 0 for awake.
+		Double x = 0, y = 0; // Center of gravity.
+		Double angle = 0;
+		Double vx = 0, vy = 0;
+		Double angularVelocity = 0;
+		Double idleTime = 0;
+	};
+	struct ConstraintRecord {
+		UInt64 id = 0;
+		Double impulse[3] = { 0, 0, 0 }; // Accumulated impulses, and the ratchet angle.
+	};
+	static_assert(sizeof(Header) == 8, "Wrong size.");
+	static_assert(sizeof(BodyRecord) == 72, "Wrong size.");
+	static_assert(sizeof(ConstraintRecord) == 32, "Wrong size.");
+
+	static void save(cpSpace* space, Bytes* bytes) {
+		struct Context {
+			Bytes* bytes = nullptr;
+			size_t offset = 0;
+			UInt32 count = 0;
+		};
+
+		Header header;
+		cpSpaceEachBody(
+			space,
+			[] (cpBody* body, void* data) -> void {
+				if (cpBodyGetType(body) != CP_BODY_TYPE_STATIC)
+					++*(UInt32*)data;
+			},
+			&header.bodyCount
+		);
+		header.constraintCount = (UInt32)space->constraints->num;
+		bytes->resize(sizeof(Header) + header.bodyCount * sizeof(BodyRecord) + header.constraintCount * sizeof(ConstraintRecord));
+		Byte* ptr = bytes->pointer();
+		memcpy(ptr, &header, sizeof(Header));
+
+		Context context;
+		context.bytes = bytes;
+		context.offset = sizeof(Header);
+		cpSpaceEachBody(
+			space,
+			[] (cpBody* body, void* data) -> void {
+				if (cpBodyGetType(body) == CP_BODY_TYPE_STATIC)
+					return;
+
+				Context* ctx = (Context*)data;
+				const cpBody* root = body->sleeping.root;
+				BodyRecord rec;
+				rec.id = (UInt64)(uintptr_t)body;
+				rec.group = (UInt64)(uintptr_t)root;
+				rec.x = body->p.x;
+				rec.y = body->p.y;
+				rec.angle = body->a;
+				rec.vx = body->v.x;
+				rec.vy = body->v.y;
+				rec.angularVelocity = body->w;
+				rec.idleTime = body->sleeping.idleTime;
+				memcpy(ctx->bytes->pointer() + ctx->offset, &rec, sizeof(BodyRecord));
+				ctx->offset += sizeof(BodyRecord);
+			},
+			&context
+		);
+
+		for (int i = 0; i < (int)header.constraintCount; ++i) {
+			cpConstraint* constraint = (cpConstraint*)space->constraints->arr[i];
+			ConstraintRecord rec;
+			rec.id = (UInt64)(uintptr_t)constraint;
+			impulse(constraint, rec.impulse, false);
+			memcpy(ptr + context.offset, &rec, sizeof(ConstraintRecord));
+			context.offset += sizeof(ConstraintRecord);
+		}
+
+		bytes->poke(0);
+	}
+	static bool load(cpSpace* space, const Bytes* bytes) {
+		const Byte* ptr = bytes->pointer();
+		if (bytes->count() < sizeof(Header))
+			return false;
+
+		Header header;
+		memcpy(&header, ptr, sizeof(Header));
+		if (bytes->count() != sizeof(Header) + header.bodyCount * sizeof(BodyRecord) + header.constraintCount * sizeof(ConstraintRecord))
+			return false;
+
+		// Restore the bodies, which activates them.
+		size_t offset = sizeof(Header);
+		bool sleeping = false;
+		for (UInt32 i = 0; i < header.bodyCount; ++i, offset += sizeof(BodyRecord)) {
+			BodyRecord rec;
+			memcpy(&rec, ptr + offset, sizeof(BodyRecord));
+			cpBody* body = BodyStates::find(space, rec.id);
+			if (!body || cpBodyGetType(body) == CP_BODY_TYPE_STATIC)
+				continue;
+
+			body->p = cpv(rec.x, rec.y);
+			cpBodySetAngle(body, rec.angle); // Also updates the transform with the position.
+			cpBodySetVelocity(body, cpv(rec.vx, rec.vy));
+			cpBodySetAngularVelocity(body, rec.angularVelocity);
+			if (rec.group)
+				sleeping = true;
+		}
+		offset = sizeof(Header);
+		for (UInt32 i = 0; i < header.bodyCount; ++i, offset += sizeof(BodyRecord)) {
+			BodyRecord rec;
+			memcpy(&rec, ptr + offset, sizeof(BodyRecord));
+			cpBody* body = BodyStates::find(space, rec.id);
+			if (body && cpBodyGetType(body) == CP_BODY_TYPE_DYNAMIC)
+				body->sleeping.idleTime = rec.idleTime;
+		}
+
+		// Put the sleeping components back to sleep, roots first.
+		if (sleeping && cpSpaceGetSleepTimeThreshold(space) < INFINITY) {
+			for (int pass = 0; pass < 2; ++pass) {
+				offset = sizeof(Header);
+				for (UInt32 i = 0; i < header.bodyCount; ++i, offset += sizeof(BodyRecord)) {
+					BodyRecord rec;
+					memcpy(&rec, ptr + offset, sizeof(BodyRecord));
+					if (!rec.group || (rec.group == rec.id) != (pass == 0))
+						continue;
+
+					cpBody* body = BodyStates::find(space, rec.id);
+					if (!body || cpBodyGetType(body) != CP_BODY_TYPE_DYNAMIC || cpBodyIsSleeping(body))
+						continue;
+
+					cpBody* root = pass == 0 ? nullptr : BodyStates::find(space, rec.group);
+					if (root && !cpBodyIsSleeping(root))
+						root = nullptr;
+					cpBodySleepWithGroup(body, root);
+				}
+			}
+		}
+
+		// Restore the constraints.
+		SpaceData* spaceData = SpaceData::get(space);
+		for (UInt32 i = 0; i < header.constraintCount; ++i, offset += sizeof(ConstraintRecord)) {
+			ConstraintRecord rec;
+			memcpy(&rec, ptr + offset, sizeof(ConstraintRecord));
+			cpConstraint* constraint = (cpConstraint*)(uintptr_t)rec.id;
+			if (!spaceData->constraintCache.find(constraint))
+				continue;
+			if (cpConstraintGetSpace(constraint) != space)
+				continue;
+
+			impulse(constraint, rec.impulse, true);
+		}
+
+		return true;
+	}
+
+private:
+	static void impulse(cpConstraint* constraint, Double* impulses, bool restore) {
+		auto exchange = [restore] (cpFloat &val, Double &rec) -> void {
+			if (restore)
+				val = rec;
+			else
+				rec = val;
+		};
+
+		if (cpConstraintIsPinJoint(constraint)) {
+			exchange(((cpPinJoint*)constraint)->jnAcc, impulses[0]);
+		} else if (cpConstraintIsSlideJoint(constraint)) {
+			exchange(((cpSlideJoint*)constraint)->jnAcc, impulses[0]);
+		} else if (cpConstraintIsPivotJoint(constraint)) {
+			exchange(((cpPivotJoint*)constraint)->jAcc.x, impulses[0]);
+			exchange(((cpPivotJoint*)constraint)->jAcc.y, impulses[1]);
+		} else if (cpConstraintIsGrooveJoint(constraint)) {
+			exchange(((cpGrooveJoint*)constraint)->jAcc.x, impulses[0]);
+			exchange(((cpGrooveJoint*)constraint)->jAcc.y, impulses[1]);
+		} else if (cpConstraintIsDampedSpring(constraint)) {
+			exchange(((cpDampedSpring*)constraint)->jAcc, impulses[0]);
+		} else if (cpConstraintIsDampedRotarySpring(constraint)) {
+			exchange(((cpDampedRotarySpring*)constraint)->jAcc, impulses[0]);
+		} else if (cpConstraintIsRotaryLimitJoint(constraint)) {
+			exchange(((cpRotaryLimitJoint*)constraint)->jAcc, impulses[0]);
+		} else if (cpConstraintIsRatchetJoint(constraint)) {
+			exchange(((cpRatchetJoint*)constraint)->jAcc, impulses[0]);
+			exchange(((cpRatchetJoint*)constraint)->angle, impulses[1]);
+		} else if (cpConstraintIsGearJoint(constraint)) {
+			exchange(((cpGearJoint*)constraint)->jAcc, impulses[0]);
+		} else if (cpConstraintIsSimpleMotor(constraint)) {
+			exchange(((cpSimpleMotor*)constraint)->jAcc, impulses[0]);
+		}
+	}
+};
+
 /**< Resetter. */
 
 template<typename Raw, typename Ptr> bool collectOne(Raw* key, Ptr &val, std::function<bool(Raw*)> func) {
@@ -1370,6 +2251,17 @@ static void collect(cpSpace* space) {
 	);
 }
 
+static void step(cpSpace* space, cpFloat delta) {
+	SpaceData* data = SpaceData::get(space);
+	if (data->hasty)
+		cpHastySpaceStep(space, delta);
+	else
+		cpSpaceStep(space, delta);
+
+	if (data->bufferedPhases)
+		data->buffer(space);
+}
+
 }
 
 }
@@ -5751,18 +6643,31 @@ static void Space_dtor(cpSpace* space) {
 
 	// Dispose the space.
 	SpaceData* data = SpaceData::get(space);
+	const bool hasty = data->hasty;
 	delete data;
 
-	cpSpaceFree(space);
+	if (hasty)
+		cpHastySpaceFree(space);
+	else
+		cpSpaceFree(space);
 }
 
 static int Space_ctor(lua_State* L) {
+	const int n = getTop(L);
+	const bool hasty = n >= 1 && isNumber(L, 1); // `nil` constructs an ordinary space.
+	int threads = 0;
+	if (hasty)
+		read<>(L, threads);
+
 	Space::Ptr obj(
-		cpSpaceNew(),
+		hasty ? cpHastySpaceNew() : cpSpaceNew(),
 		Space_dtor
 	);
 	SpaceData* data = new SpaceData(obj, L);
+	data->hasty = hasty;
 	cpSpaceSetUserData(obj.get(), data);
+	if (data->hasty)
+		cpHastySpaceSetThreads(obj.get(), (unsigned long)std::max(threads, 0));
 
 	return write(L, &obj);
 }
@@ -6548,6 +7453,61 @@ static int Space_boundingBoxQueryAll(lua_State* L) {
 	return write(L, nullptr);
 }
 
+template<typename Query> static int Space_queryMany(lua_State* L, int (* solve)(cpSpace*, const Query*, int, const cpShapeFilter &, bool, BatchQueries::Array &)) {
+	const int n = getTop(L);
+	Space::Ptr* obj = nullptr;
+	Bytes::Ptr* queries = nullptr;
+	ShapeFilter::Ptr* filter = nullptr;
+	Bytes::Ptr* hits = nullptr;
+	if (n >= 4)
+		read<>(L, obj, queries, filter, hits);
+	else if (n == 3)
+		read<>(L, obj, queries, filter);
+	else
+		read<>(L, obj, queries);
+
+	if (!obj || !obj->get())
+		return 0;
+
+	if (!queries || !queries->get()) {
+		error(L, "Bytes expected.");
+
+		return 0;
+	}
+
+	const int count = (int)(queries->get()->count() / sizeof(Query));
+	std::vector<Query> queries_(count);
+	if (count > 0)
+		memcpy(&queries_.front(), queries->get()->pointer(), count * sizeof(Query));
+	const cpShapeFilter filter_ = (filter && filter->get()) ? *filter->get() : CP_SHAPE_FILTER_ALL;
+	BatchQueries::Array hits_;
+	const int ret = count > 0 ? solve(obj->get(), &queries_.front(), count, filter_, true, hits_) : 0;
+
+	Bytes::Ptr bytes = nullptr;
+	if (hits && hits->get())
+		bytes = *hits;
+	else
+		bytes = Bytes::Ptr(Bytes::create());
+	bytes->resize(hits_.size() * sizeof(BatchQueries::Hit));
+	if (!hits_.empty())
+		memcpy(bytes->pointer(), &hits_.front(), hits_.size() * sizeof(BatchQueries::Hit));
+	bytes->poke(0);
+
+	return write(L, &bytes, ret);
+}
+
+static int Space_pointQueryNearestMany(lua_State* L) {
+	return Space_queryMany<BatchQueries::Point>(L, BatchQueries::pointNearest);
+}
+
+static int Space_segmentQueryFirstMany(lua_State* L) {
+	return Space_queryMany<BatchQueries::Segment>(L, BatchQueries::segmentFirst);
+}
+
+static int Space_boundingBoxQueryMany(lua_State* L) {
+	return Space_queryMany<BatchQueries::Box>(L, BatchQueries::boundingBox);
+}
+
 static int Space_shapeQuery(lua_State* L) {
 	Space::Ptr* obj = nullptr;
 	Shape::Ptr* shape = nullptr;
@@ -6777,9 +7737,13 @@ static int Space_useSpatialHash(lua_State* L) {
 	int count = 0;
 	read<>(L, obj, dim, count);
 
-	if (obj && obj->get())
+	if (obj && obj->get()) {
 		cpSpaceUseSpatialHash(obj->get(), dim, count);
 
+		SpaceData* spaceData = SpaceData::get(obj->get());
+		spaceData->spatialHash = true;
+	}
+
 	return 0;
 }
 
@@ -6789,7 +7753,7 @@ static int Space_step(lua_State* L) {
 	read<>(L, obj, delta);
 
 	if (obj && obj->get()) {
-		cpSpaceStep(obj->get(), delta);
+		step(obj->get(), delta);
 
 		SpaceData* spaceData = SpaceData::get(obj->get());
 		if (spaceData->obsoleteCollectEnabled) {
@@ -6803,6 +7767,309 @@ static int Space_step(lua_State* L) {
 	return 0;
 }
 
+static int Space_stepFixed(lua_State* L) {
+	const int n = getTop(L);
+	Space::Ptr* obj = nullptr;
+	cpFloat delta = 0;
+	cpFloat hz = 60;
+	int maxSubsteps = 5;
+	if (n >= 4)
+		read<>(L, obj, delta, hz, maxSubsteps);
+	else if (n == 3)
+		read<>(L, obj, delta, hz);
+	else
+		read<>(L, obj, delta);
+
+	if (!obj || !obj->get())
+		return 0;
+
+	if (hz <= 0) {
+		error(L, "Positive frequency expected.");
+
+		return 0;
+	}
+
+	SpaceData* spaceData = SpaceData::get(obj->get());
+	const cpFloat fixed = 1 / hz;
+	maxSubsteps = std::max(maxSubsteps, 1);
+	spaceData->fixedAccumulator += std::max(delta, (cpFloat)0);
+	int substeps = 0;
+	while (spaceData->fixedAccumulator >= fixed && substeps < maxSubsteps) {
+		spaceData->fixedAccumulator -= fixed;
+		if (spaceData->fixedAccumulator < fixed || substeps + 1 == maxSubsteps)
+			spaceData->capture(obj->get()); // Only the poses before the last substep are needed.
+		step(obj->get(), fixed);
+		++substeps;
+	}
+	if (spaceData->fixedAccumulator >= fixed)
+		spaceData->fixedAccumulator = std::fmod(spaceData->fixedAccumulator, fixed); // Dropped the whole steps exceeding the limit, keeps the fraction.
+	spaceData->fixedAlpha = Math::clamp(spaceData->fixedAccumulator / fixed, (cpFloat)0, (cpFloat)1);
+
+	if (substeps > 0 && spaceData->obsoleteCollectEnabled) {
+		if (spaceData->obsoleteObjectCount >= spaceData->obsoleteCollectThreshold) {
+			collect(obj->get());
+			spaceData->obsoleteObjectCount = 0;
+		}
+	}
+
+	return write(L, substeps, spaceData->fixedAlpha);
+}
+
+static int Space_exportBodies(lua_State* L) {
+	const int n = getTop(L);
+	Space::Ptr* obj = nullptr;
+	Bytes::Ptr* bytes = nullptr;
+	unsigned fields = BodyStates::ID | BodyStates::POSITION | BodyStates::ANGLE;
+	if (n >= 3)
+		read<>(L, obj, bytes, fields);
+	else
+		read<>(L, obj, bytes);
+
+	if (!obj || !obj->get())
+		return 0;
+
+	if (!bytes || !bytes->get()) {
+		error(L, "Bytes expected.");
+
+		return 0;
+	}
+
+	BodyStates::Array bodies;
+	BodyStates::collect(L, 4, obj->get(), bodies);
+
+	const SpaceData* spaceData = SpaceData::get(obj->get());
+	const bool interpolated = !!(fields & BodyStates::INTERPOLATED);
+	const size_t size = BodyStates::size(fields);
+	(*bytes)->resize(bodies.size() * size);
+	Byte* ptr = (*bytes)->pointer();
+	for (cpBody* body : bodies) {
+		const BodyStates::Record rec = body ?
+			(interpolated ? BodyStates::of(body, spaceData) : BodyStates::of(body)) :
+			BodyStates::Record();
+		ptr = BodyStates::pack(ptr, rec, fields);
+	}
+	(*bytes)->poke(0);
+
+	return write(L, (int)bodies.size());
+}
+
+static int Space_importBodies(lua_State* L) {
+	const int n = getTop(L);
+	Space::Ptr* obj = nullptr;
+	Bytes::Ptr* bytes = nullptr;
+	unsigned fields = BodyStates::ID | BodyStates::POSITION | BodyStates::ANGLE;
+	Placeholder _4;
+	cpFloat delta = 0;
+	if (n >= 5)
+		read<>(L, obj, bytes, fields, _4, delta);
+	else if (n >= 3)
+		read<>(L, obj, bytes, fields);
+	else
+		read<>(L, obj, bytes);
+
+	if (!obj || !obj->get())
+		return 0;
+
+	if (!bytes || !bytes->get()) {
+		error(L, "Bytes expected.");
+
+		return 0;
+	}
+	if (cpSpaceIsLocked(obj->get())) {
+		error(L, "Cannot import bodies when the Space is locked.");
+
+		return 0;
+	}
+
+	const size_t size = BodyStates::size(fields);
+	if (size == 0)
+		return write(L, 0);
+
+	BodyStates::Array bodies;
+	if (!(fields & BodyStates::ID))
+		BodyStates::collect(L, 4, obj->get(), bodies);
+
+	const int count = (int)((*bytes)->count() / size);
+	const Byte* ptr = (*bytes)->pointer();
+	int result = 0;
+	for (int i = 0; i < count; ++i) {
+		BodyStates::Record rec;
+		ptr = BodyStates::unpack(ptr, rec, fields);
+
+		cpBody* body = nullptr;
+		if (fields & BodyStates::ID)
+			body = BodyStates::find(obj->get(), rec.id);
+		else if (i < (int)bodies.size())
+			body = bodies[i];
+		if (!body)
+			continue;
+
+		const cpBodyType y = cpBodyGetType(body);
+		if (y == CP_BODY_TYPE_KINEMATIC && delta > 0) {
+			// Drives kinematic bodies towards the targets during the next step.
+			if (fields & BodyStates::POSITION)
+				cpBodySetVelocity(body, cpvmult(cpvsub(rec.position, cpBodyGetPosition(body)), 1 / delta));
+			else if (fields & BodyStates::VELOCITY)
+				cpBodySetVelocity(body, rec.velocity);
+			if (fields & BodyStates::ANGLE)
+				cpBodySetAngularVelocity(body, (rec.angle - cpBodyGetAngle(body)) / delta);
+			else if (fields & BodyStates::ANGULAR_VELOCITY)
+				cpBodySetAngularVelocity(body, rec.angularVelocity);
+		} else {
+			if (fields & BodyStates::POSITION)
+				cpBodySetPosition(body, rec.position);
+			if (fields & BodyStates::ANGLE)
+				cpBodySetAngle(body, rec.angle);
+			if (fields & BodyStates::VELOCITY)
+				cpBodySetVelocity(body, rec.velocity);
+			if (fields & BodyStates::ANGULAR_VELOCITY)
+				cpBodySetAngularVelocity(body, rec.angularVelocity);
+			if (y == CP_BODY_TYPE_STATIC && cpBodyGetSpace(body) && (fields & (BodyStates::POSITION | BodyStates::ANGLE)))
+				cpSpaceReindexShapesForBody(cpBodyGetSpace(body), body);
+		}
+		++result;
+	}
+
+	return write(L, result);
+}
+
+static int Space_bufferCollisionEvents(lua_State* L) {
+	const int n = getTop(L);
+	Space::Ptr* obj = nullptr;
+	unsigned phases = SpaceData::COLLISION_BEGAN | SpaceData::COLLISION_PERSISTED | SpaceData::COLLISION_SEPARATED;
+	if (n >= 2)
+		read<>(L, obj, phases);
+	else
+		read<>(L, obj);
+
+	if (obj && obj->get()) {
+		SpaceData* spaceData = SpaceData::get(obj->get());
+		spaceData->bufferedPhases = phases;
+		if (!phases) {
+			spaceData->collisionEvents.clear();
+			spaceData->collisionContacts.clear();
+		}
+	}
+
+	return 0;
+}
+
+static int Space_drainCollisionEvents(lua_State* L) {
+	Space::Ptr* obj = nullptr;
+	Bytes::Ptr* bytes = nullptr;
+	read<>(L, obj, bytes);
+
+	if (!obj || !obj->get())
+		return 0;
+
+	if (!bytes || !bytes->get()) {
+		error(L, "Bytes expected.");
+
+		return 0;
+	}
+
+	SpaceData* spaceData = SpaceData::get(obj->get());
+	SpaceData::CollisionEventArray &events = spaceData->collisionEvents;
+	const int count = (int)events.size();
+	(*bytes)->resize(count * sizeof(SpaceData::CollisionEvent));
+	if (count > 0)
+		memcpy((*bytes)->pointer(), &events.front(), count * sizeof(SpaceData::CollisionEvent));
+	(*bytes)->poke(0);
+	events.clear();
+
+	return write(L, count);
+}
+
+static int Space_snapshot(lua_State* L) {
+	const int n = getTop(L);
+	Space::Ptr* obj = nullptr;
+	Bytes::Ptr* bytes = nullptr;
+	if (n >= 2)
+		read<>(L, obj, bytes);
+	else
+		read<>(L, obj);
+
+	if (!obj || !obj->get())
+		return 0;
+
+	Bytes::Ptr ret = nullptr;
+	if (bytes && bytes->get())
+		ret = *bytes;
+	else
+		ret = Bytes::Ptr(Bytes::create());
+	Snapshot::save(obj->get(), ret.get());
+
+	return write(L, &ret);
+}
+
+static int Space_restore(lua_State* L) {
+	Space::Ptr* obj = nullptr;
+	Bytes::Ptr* bytes = nullptr;
+	read<>(L, obj, bytes);
+
+	if (!obj || !obj->get())
+		return 0;
+
+	if (!bytes || !bytes->get()) {
+		error(L, "Bytes expected.");
+
+		return 0;
+	}
+
+	if (cpSpaceIsLocked(obj->get())) {
+		error(L, "Cannot restore a locked space.");
+
+		return 0;
+	}
+
+	const bool ret = Snapshot::load(obj->get(), bytes->get());
+
+	return write(L, ret);
+}
+
+static int Space_debugDraw(lua_State* L) {
+	const int n = getTop(L);
+	Space::Ptr* obj = nullptr;
+	unsigned flags = DebugDrawer::SHAPES | DebugDrawer::CONSTRAINTS | DebugDrawer::COLLISION_POINTS;
+	Color* outlineColor = nullptr;
+	Color* fillColor = nullptr;
+	Color* constraintColor = nullptr;
+	Color* collisionPointColor = nullptr;
+	if (n >= 6)
+		read<>(L, obj, flags, outlineColor, fillColor, constraintColor, collisionPointColor);
+	else if (n == 5)
+		read<>(L, obj, flags, outlineColor, fillColor, constraintColor);
+	else if (n == 4)
+		read<>(L, obj, flags, outlineColor, fillColor);
+	else if (n == 3)
+		read<>(L, obj, flags, outlineColor);
+	else if (n == 2)
+		read<>(L, obj, flags);
+	else
+		read<>(L, obj);
+
+	if (!obj || !obj->get())
+		return 0;
+
+	ScriptingLua* impl = ScriptingLua::instanceOf(L);
+	const Primitives* primitives = impl->primitives();
+	if (!primitives)
+		return 0;
+
+	DebugDrawer drawer;
+	if (fillColor)
+		drawer.fillColor = *fillColor;
+	drawer.draw(
+		obj->get(), flags,
+		outlineColor ? *outlineColor : Color(200, 210, 230, 255),
+		constraintColor ? *constraintColor : Color(0, 191, 0, 255),
+		collisionPointColor ? *collisionPointColor : Color(255, 0, 0, 255),
+		primitives
+	);
+
+	return 0;
+}
+
 static int Space_collect(lua_State* L) {
 	const int n = getTop(L);
 	Space::Ptr* obj = nullptr;
@@ -6955,6 +8222,11 @@ static int Space___index(lua_State* L) {
 		};
 		cpSpaceEachConstraint(obj->get(), callback_, &data);
 
+		return write(L, ret);
+	} else if (strcmp(field, "threads") == 0) {
+		SpaceData* spaceData = SpaceData::get(obj->get());
+		const int ret = spaceData->hasty ? (int)cpHastySpaceGetThreads(obj->get()) : 1;
+
 		return write(L, ret);
 	} else {
 		return __index(L, field);
@@ -7058,11 +8330,14 @@ static void open_Space(lua_State* L) {
 			luaL_Reg{ "pointQuery", Space_pointQuery },
 			luaL_Reg{ "pointQueryAll", Space_pointQueryAll },
 			luaL_Reg{ "pointQueryNearest", Space_pointQueryNearest },
+			luaL_Reg{ "pointQueryNearestMany", Space_pointQueryNearestMany },
 			luaL_Reg{ "segmentQuery", Space_segmentQuery },
 			luaL_Reg{ "segmentQueryAll", Space_segmentQueryAll },
 			luaL_Reg{ "segmentQueryFirst", Space_segmentQueryFirst },
+			luaL_Reg{ "segmentQueryFirstMany", Space_segmentQueryFirstMany },
 			luaL_Reg{ "boundingBoxQuery", Space_boundingBoxQuery },
 			luaL_Reg{ "boundingBoxQueryAll", Space_boundingBoxQueryAll },
+			luaL_Reg{ "boundingBoxQueryMany", Space_boundingBoxQueryMany },
 			luaL_Reg{ "shapeQuery", Space_shapeQuery },
 			luaL_Reg{ "shapeQueryAll", Space_shapeQueryAll },
 			luaL_Reg{ "query", Space_query },
@@ -7075,6 +8350,14 @@ static void open_Space(lua_State* L) {
 			luaL_Reg{ "reindexShapesForBody", Space_reindexShapesForBody },
 			luaL_Reg{ "useSpatialHash", Space_useSpatialHash },
 			luaL_Reg{ "step", Space_step },
+			luaL_Reg{ "stepFixed", Space_stepFixed },
+			luaL_Reg{ "exportBodies", Space_exportBodies },
+			luaL_Reg{ "importBodies", Space_importBodies },
+			luaL_Reg{ "bufferCollisionEvents", Space_bufferCollisionEvents },
+			luaL_Reg{ "drainCollisionEvents", Space_drainCollisionEvents },
+			luaL_Reg{ "snapshot", Space_snapshot },
+			luaL_Reg{ "restore", Space_restore },
+			luaL_Reg{ "debugDraw", Space_debugDraw },
 			luaL_Reg{ "collect", Space_collect },
 			luaL_Reg{ nullptr, nullptr }
 		),
@@ -7084,6 +8367,21 @@ static void open_Space(lua_State* L) {
 	getGlobal(L, "Space");
 	setTable(
 		L,
+		"Id", (Enum)BodyStates::ID,
+		"Position", (Enum)BodyStates::POSITION,
+		"Angle", (Enum)BodyStates::ANGLE,
+		"Velocity", (Enum)BodyStates::VELOCITY,
+		"AngularVelocity", (Enum)BodyStates::ANGULAR_VELOCITY,
+		"Interpolated", (Enum)BodyStates::INTERPOLATED,
+
+		"CollisionBegan", (Enum)SpaceData::COLLISION_BEGAN,
+		"CollisionPersisted", (Enum)SpaceData::COLLISION_PERSISTED,
+		"CollisionSeparated", (Enum)SpaceData::COLLISION_SEPARATED,
+
+		"DrawShapes", (Enum)DebugDrawer::SHAPES,
+		"DrawConstraints", (Enum)DebugDrawer::CONSTRAINTS,
+		"DrawCollisionPoints", (Enum)DebugDrawer::COLLISION_POINTS,
+
 		"__name", "Space"
 	);
 	pop(L);
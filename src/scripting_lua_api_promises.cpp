@@ -13,6 +13,7 @@
 #include "datetime.h"
 #include "filesystem.h"
 #include "json.h"
+#include "pathfinder.h"
 #include "scripting_lua.h"
 #include "scripting_lua_api_promises.h"
 #include "web.h"
@@ -67,6 +68,14 @@ LUA_READ_OBJ(Json)
 LUA_WRITE_OBJ(Json)
 LUA_WRITE_OBJ_CONST(Json)
 
+/**< Math. */
+
+LUA_WRITE_ALIAS(Math::Vec2f, Vec2)
+LUA_WRITE_ALIAS_CONST(Math::Vec2f, Vec2)
+
+LUA_WRITE_CAST(Math::Vec2f, Math::Vec2i, [] (const Math::Vec2i &val) -> Math::Vec2f { return Math::Vec2f(val.x, val.y); })
+LUA_WRITE_CAST_CONST(Math::Vec2f, Math::Vec2i, [] (const Math::Vec2i &val) -> Math::Vec2f { return Math::Vec2f(val.x, val.y); })
+
 }
 
 #if defined BITTY_OS_HTML
@@ -162,6 +171,12 @@ static int Promise_write(lua_State* L, const Variant &arg) {
 	if (json)
 		return write(L, &json);
 
+	Pathfinder::Result::Ptr path = nullptr;
+	if (Object::is<Pathfinder::Result::Ptr>(obj))
+		path = Object::as<Pathfinder::Result::Ptr>(obj);
+	if (path)
+		return write(L, path->path);
+
 	return write(L, &arg);
 }
 
@@ -191,6 +206,12 @@ static int Promise_call(lua_State* L, Function::Ptr* ptr, const Variant &arg) {
 	if (json)
 		return ScriptingLua::check(L, call(L, **ptr, &json));
 
+	Pathfinder::Result::Ptr path = nullptr;
+	if (Object::is<Pathfinder::Result::Ptr>(obj))
+		path = Object::as<Pathfinder::Result::Ptr>(obj);
+	if (path)
+		return ScriptingLua::check(L, call(L, **ptr, path->path, path->cost));
+
 	return general(L, ptr, arg);
 }
 
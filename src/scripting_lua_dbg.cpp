@@ -54,12 +54,53 @@ bool Breakpoint::operator < (const Breakpoint &other) const {
 	return scriptingLuaDbgCompare(*this, other) < 0;
 }
 
+const Breakpoints::Bitmap::Bits* Breakpoints::Bitmap::find(const char* src) const {
+	if (!src)
+		return nullptr;
+
+	Dictionary::const_iterator it = sources.find(src);
+	if (it == sources.end())
+		return nullptr;
+
+	return &it->second;
+}
+
+bool Breakpoints::Bitmap::test(const char* src, int ln) const {
+	return test(find(src), ln);
+}
+
+bool Breakpoints::Bitmap::test(const Bits* bits, int ln) {
+	if (!bits || ln < 0)
+		return false;
+
+	const size_t idx = (size_t)ln / (sizeof(unsigned) * 8);
+	if (idx >= bits->size())
+		return false;
+
+	return !!((*bits)[idx] & (1u << ((size_t)ln % (sizeof(unsigned) * 8))));
+}
+
+Breakpoints::Breakpoints() {
+}
+
+Breakpoints::~Breakpoints() {
+	for (const Bitmap* bmp : retired)
+		delete bmp;
+	retired.clear();
+	delete (const Bitmap*)bitmap;
+	bitmap = nullptr;
+}
+
 size_t Breakpoints::count(void) const {
 	return collection.size();
 }
 
 Breakpoint &Breakpoints::add(const Breakpoint &brk) {
-	return *collection.insert(std::upper_bound(collection.begin(), collection.end(), brk), brk);
+	Breakpoint &result = *collection.insert(std::upper_bound(collection.begin(), collection.end(), brk), brk);
+
+	publish();
+
+	return result;
 }
 
 bool Breakpoints::remove(size_t index) {
@@ -68,6 +109,8 @@ bool Breakpoints::remove(size_t index) {
 
 	collection.erase(collection.begin() + index);
 
+	publish();
+
 	return true;
 }
 
@@ -100,6 +143,8 @@ bool Breakpoints::empty(void) const {
 
 void Breakpoints::clear(void) {
 	collection.clear();
+
+	publish();
 }
 
 Breakpoints::Iterator Breakpoints::begin(void) {
@@ -119,7 +164,50 @@ Breakpoints::ConstIterator Breakpoints::end(void) const {
 }
 
 Breakpoints::Iterator Breakpoints::erase(ConstIterator it) {
-	return collection.erase(it);
+	Iterator result = collection.erase(it);
+
+	publish();
+
+	return result;
+}
+
+void Breakpoints::reclaim(const Bitmap* inUse) {
+	LockGuard<decltype(lock)> guard(lock);
+
+	Bitmaps::iterator it = retired.begin();
+	while (it != retired.end()) {
+		if (*it == inUse) {
+			++it;
+
+			continue;
+		}
+
+		delete *it;
+		it = retired.erase(it);
+	}
+	observed = inUse;
+}
+
+void Breakpoints::publish(void) {
+	Bitmap* bmp = nullptr;
+	if (!collection.empty()) {
+		bmp = new Bitmap();
+		for (const Breakpoint &brk : collection) {
+			if (brk.line < 0)
+				continue;
+
+			Bitmap::Bits &bits = bmp->sources[brk.source];
+			const size_t idx = (size_t)brk.line / (sizeof(unsigned) * 8);
+			if (idx >= bits.size())
+				bits.resize(idx + 1, 0);
+			bits[idx] |= 1u << ((size_t)brk.line % (sizeof(unsigned) * 8));
+		}
+	}
+
+	const Bitmap* old = bitmap;
+	bitmap = bmp;
+	if (old)
+		retired.push_back(old);
 }
 
 Variable &Variable::List::add(const Variable &var) {
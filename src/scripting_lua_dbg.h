@@ -13,6 +13,7 @@
 
 #include "object.h"
 #include "plus.h"
+#include <map>
 #include <vector>
 
 /*
@@ -31,14 +32,37 @@ struct Breakpoint {
 };
 
 struct Breakpoints {
+	/**
+	 * @brief Immutable line bitmaps of the breakpoints for each source, which
+	 *   are read by the Lua thread without lock.
+	 */
+	struct Bitmap {
+		typedef std::vector<unsigned> Bits;
+		typedef std::map<std::string, Bits, std::less<> > Dictionary; // Transparent, finds by `const char*` without making a string.
+
+		Dictionary sources;
+
+		const Bits* find(const char* src) const;
+		bool test(const char* src, int ln) const;
+
+		static bool test(const Bits* bits, int ln);
+	};
+	typedef std::vector<const Bitmap*> Bitmaps;
+
 	typedef std::vector<Breakpoint> Collection;
 
 	typedef std::vector<Breakpoint>::iterator Iterator;
 	typedef std::vector<Breakpoint>::const_iterator ConstIterator;
 
 	Collection collection;
+	Atomic<const Bitmap*> bitmap { nullptr }; // Republished on every change, `nullptr` for no breakpoint.
+	Bitmaps retired; // Kept alive until reclaimed by the reader, since it doesn't lock.
+	const Bitmap* observed = nullptr; // The latest bitmap seen by the reader, accessed by the Lua thread only.
 	mutable Mutex lock;
 
+	Breakpoints();
+	~Breakpoints();
+
 	size_t count(void) const;
 	Breakpoint &add(const Breakpoint &brk);
 	bool remove(size_t index);
@@ -52,6 +76,16 @@ struct Breakpoints {
 	ConstIterator begin(void) const;
 	ConstIterator end(void) const;
 	Iterator erase(ConstIterator it);
+
+	/**
+	 * @brief Frees the retired bitmaps except the one still in use; only
+	 *   called by the Lua thread, which is the only reader, so no other
+	 *   bitmap can be referenced at the moment.
+	 */
+	void reclaim(const Bitmap* inUse /* nullable */);
+
+private:
+	void publish(void);
 };
 
 struct Variable {
@@ -8,7 +8,21 @@
 ** For the latest info, see https://github.com/paladin-t/bitty/
 */
 
+#include "grid.h"
 #include "walker.h"
+#include "plus.h"
+#include <vector>
+
+/*
+** {===========================================================================
+** Macros and constants
+*/
+
+#ifndef WALKER_PARALLEL_MIN_COUNT
+#	define WALKER_PARALLEL_MIN_COUNT 128
+#endif /* WALKER_PARALLEL_MIN_COUNT */
+
+/* ===========================================================================} */
 
 /*
 ** {===========================================================================
@@ -60,6 +74,127 @@ public:
 		Math::Vec2f &newDir,
 		int slidable
 	) override {
+		BlockingHandler block = nullptr;
+		if (access.isLeft()) {
+			block = access.left().get();
+		} else {
+			EvaluationHandler eval = access.right().get();
+			block = [eval] (const Math::Vec2i &pos) -> Blocking {
+				return Blocking(eval(pos) > 15, NONE);
+			};
+		}
+
+		return solve(objPos, expDir, block, newDir, slidable);
+	}
+	virtual int solve(
+		const Math::Vec2f &objPos, const Math::Vec2f &expDir,
+		const Grid* grid,
+		Math::Vec2f &newDir,
+		int slidable
+	) override {
+		newDir = Math::Vec2f(0, 0);
+
+		if (!grid)
+			return 0;
+
+		auto block = [grid] (const Math::Vec2i &pos) -> Blocking {
+			return Blocking(grid->get((int)pos.x, (int)pos.y), NONE);
+		};
+
+		return solve(objPos, expDir, block, newDir, slidable);
+	}
+	virtual int solve(
+		const Motion* motions, int count,
+		const AccessHandler &access, bool parallel,
+		Direction* newDirs,
+		int slidable
+	) override {
+		if (access.isLeft()) {
+			const BlockingHandler block = access.left().get();
+
+			return solve(motions, count, block, parallel, newDirs, slidable);
+		} else {
+			const EvaluationHandler eval = access.right().get();
+			auto block = [&eval] (const Math::Vec2i &pos) -> Blocking {
+				return Blocking(eval(pos) > 15, NONE);
+			};
+
+			return solve(motions, count, block, parallel, newDirs, slidable);
+		}
+	}
+	virtual int solve(
+		const Motion* motions, int count,
+		const Grid* grid, bool parallel,
+		Direction* newDirs,
+		int slidable
+	) override {
+		if (!grid) {
+			for (int i = 0; i < count; ++i)
+				newDirs[i] = Direction();
+
+			return 0;
+		}
+
+		auto block = [grid] (const Math::Vec2i &pos) -> Blocking {
+			return Blocking(grid->get((int)pos.x, (int)pos.y), NONE);
+		};
+
+		return solve(motions, count, block, parallel, newDirs, slidable);
+	}
+
+private:
+	template<typename B> int solve(
+		const Motion* motions, int count,
+		const B &block, bool parallel,
+		Direction* newDirs,
+		int slidable
+	) {
+		auto proc = [this, motions, newDirs, slidable, &block] (int begin, int end) -> int {
+			int result = 0;
+			for (int i = begin; i < end; ++i) {
+				const Motion &motion = motions[i];
+				Math::Vec2f newDir(0, 0);
+				const int ret = solve(
+					Math::Vec2f(motion.x, motion.y), Math::Vec2f(motion.dx, motion.dy),
+					block,
+					newDir,
+					slidable
+				);
+				newDirs[i].dx = (Single)newDir.x;
+				newDirs[i].dy = (Single)newDir.y;
+				if (ret)
+					++result;
+			}
+
+			return result;
+		};
+
+		const int n = Parallel::chunks(count, WALKER_PARALLEL_MIN_COUNT, parallel);
+		if (n > 1) {
+			std::vector<int> results(n, 0);
+			Parallel::fork(
+				count, n,
+				[&proc, &results] (int chunk, int begin, int end) -> void {
+					results[chunk] = proc(begin, end);
+				}
+			);
+
+			int result = 0;
+			for (int r : results)
+				result += r;
+
+			return result;
+		}
+
+		return proc(0, count);
+	}
+
+	template<typename B> int solve(
+		const Math::Vec2f &objPos, const Math::Vec2f &expDir,
+		const B &block,
+		Math::Vec2f &newDir,
+		int slidable
+	) {
 		if (_objSize.x <= 0 || _objSize.y <= 0)
 			return 0;
 		if (_tileSize.x <= 0 || _tileSize.y <= 0)
@@ -68,7 +203,7 @@ public:
 		const Real expDirX = expDir.x, expDirY = expDir.y;
 		int n = tend( // Tend straightforward.
 			objPos, expDir,
-			access,
+			block,
 			newDir,
 			slidable,
 			&_objSize, &_tileSize, &_offset
@@ -84,7 +219,7 @@ public:
 			Math::Vec2f newNewDir(0, 0);
 			n = tend( // Tend into a new direction.
 				objPos, newExpDir,
-				access,
+				block,
 				newNewDir,
 				slidable,
 				&_objSize, &_tileSize, &_offset
@@ -99,10 +234,9 @@ public:
 		return n;
 	}
 
-private:
-	template<typename T = Real> static int tend(
+	template<typename B, typename T = Real> static int tend(
 		const Math::Vec2f &objPos, const Math::Vec2f &expDir,
-		const AccessHandler &access,
+		const B &block,
 		Math::Vec2f &newDir,
 		int slidable,
 		const Math::Vec2i* objSize_, const Math::Vec2i* tileSize_, const Math::Vec2f* offset
@@ -116,16 +250,6 @@ private:
 		const Math::Vec2i objSize = objSize_ ? *objSize_ : Math::Vec2i(BITTY_GRID_DEFAULT_SIZE, BITTY_GRID_DEFAULT_SIZE);
 		const Math::Vec2i tileSize = tileSize_ ? *tileSize_ : Math::Vec2i(BITTY_GRID_DEFAULT_SIZE, BITTY_GRID_DEFAULT_SIZE);
 
-		BlockingHandler block = nullptr;
-		if (access.isLeft()) {
-			block = access.left().get();
-		} else {
-			EvaluationHandler eval = access.right().get();
-			block = [eval] (const Math::Vec2i &pos) -> Blocking {
-				return Blocking(eval(pos) > 15, NONE);
-			};
-		}
-
 		if (expDir.x == 0 && expDir.y == 0) {
 			newDir.x = newDir.y = 0;
 
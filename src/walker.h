@@ -49,6 +49,23 @@ public:
 
 	typedef Either<BlockingHandler, EvaluationHandler> AccessHandler;
 
+	/**
+	 * @brief Object position and expected direction for bulk solving.
+	 */
+	struct Motion {
+		Single x = 0;
+		Single y = 0;
+		Single dx = 0;
+		Single dy = 0;
+	};
+	/**
+	 * @brief Resolved direction for bulk solving.
+	 */
+	struct Direction {
+		Single dx = 0;
+		Single dy = 0;
+	};
+
 public:
 	BITTY_CLASS_TYPE('W', 'L', 'K', 'R')
 
@@ -70,6 +87,39 @@ public:
 		Math::Vec2f &newDir,
 		int slidable
 	) = 0;
+	/**
+	 * @param[out] newDir
+	 */
+	virtual int solve(
+		const Math::Vec2f &objPos, const Math::Vec2f &expDir,
+		const class Grid* grid,
+		Math::Vec2f &newDir,
+		int slidable
+	) = 0;
+	/**
+	 * @brief Solves for many objects in bulk; splits them across threads if
+	 *   `parallel` is true and there are enough objects, then the access
+	 *   handler must be safe to be invoked from several threads.
+	 *
+	 * @param[out] newDirs
+	 * @return The count of the objects that can move.
+	 */
+	virtual int solve(
+		const Motion* motions, int count,
+		const AccessHandler &access, bool parallel,
+		Direction* newDirs,
+		int slidable
+	) = 0;
+	/**
+	 * @param[out] newDirs
+	 * @return The count of the objects that can move.
+	 */
+	virtual int solve(
+		const Motion* motions, int count,
+		const class Grid* grid, bool parallel,
+		Direction* newDirs,
+		int slidable
+	) = 0;
 
 	static Walker* create(void);
 	static void destroy(Walker* ptr);